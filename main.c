@@ -2,15 +2,62 @@
 #define NDEBUG
 #endif
 
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAS_SSE2
+#include <emmintrin.h>
+#endif
 #include "glad.h"
 #include "glfw3.h"
 #define STBI_FAILURE_USERMSG
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+/* cells are uploaded in bands of roughly this many bytes, streamed through a small ring of
+   pixel buffer objects so that copying the next band overlaps the transfer of the last. runs
+   for the GPU to rasterize go through the same ring in batches of the same size */
+#define UPLOAD_BAND_SIZE (4 << 20)
+#define NUM_UPLOAD_BUFFERS 3
+
+/* sync objects are OpenGL 3.2, which is newer than our loader, so they're loaded by hand when available */
+typedef struct __GLsync *GLsync;
+typedef uint64_t GLuint64;
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_CONDITION_SATISFIED 0x911C
+typedef GLsync (APIENTRY *PFNGLFENCESYNCPROC)(GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRY *PFNGLCLIENTWAITSYNCPROC)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (APIENTRY *PFNGLDELETESYNCPROC)(GLsync sync);
+/* and so are timer queries, which are OpenGL 3.3 */
+typedef int64_t GLint64;
+#define GL_TIMESTAMP 0x8E28
+#define GL_TIME_ELAPSED 0x88BF
+typedef void (APIENTRY *PFNGLQUERYCOUNTERPROC)(GLuint id, GLenum target);
+typedef void (APIENTRY *PFNGLGETQUERYOBJECTUI64VPROC)(GLuint id, GLenum pname, GLuint64 *params);
+typedef void (APIENTRY *PFNGLGETINTEGER64VPROC)(GLenum pname, GLint64 *data);
+
 /* run on a dedicated GPU if avaliable https://stackoverflow.com/a/39047129 */
 #ifdef _MSC_VER
 __declspec(dllexport) unsigned long NvOptimusEnablement = 1;
@@ -44,12 +91,71 @@ GLuint cellsReadFramebuffer;
 GLuint cellsWriteFramebuffer;
 GLuint renderProgram;
 GLuint updateProgram;
+/* what updateCells runs on, for the hud */
+const char *updateKernelName = "fragment shader";
 GLint uniformScale;
 GLint uniformOffset;
 GLint uniformBorderSize;
 GLint uniformBackgroundColor;
 GLint uniformDeadColor;
 GLint uniformAliveColor;
+GLuint uploadBuffers[NUM_UPLOAD_BUFFERS];
+int nextUploadBuffer;
+GLuint runProgram;
+GLint uniformRunNumCells;
+GLuint vertexArray;
+GLuint runVertexArray;
+GLint runPositionLocation;
+GLuint hudProgram;
+GLint uniformHudWindowSize;
+GLuint hudVertexArray;
+GLuint hudVertexBuffer;
+GLboolean gpuDecodeIsOn = GL_FALSE;
+/* how patterns dropped with shift held are combined with the cells already there */
+typedef enum PasteMode {
+	PASTE_COPY,
+	PASTE_OR,
+	PASTE_XOR,
+	NUM_PASTE_MODES
+} PasteMode;
+PasteMode pasteMode = PASTE_COPY;
+/* how far along a pattern load is, for the window title. loaders that can tell set the total
+   number of steps and count them off as they go, from any thread */
+volatile int loadSteps = 0;
+volatile int loadStepsDone = 0;
+PFNGLFENCESYNCPROC glFenceSync;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+PFNGLDELETESYNCPROC glDeleteSync;
+PFNGLQUERYCOUNTERPROC glQueryCounter;
+PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v;
+PFNGLGETINTEGER64VPROC glGetInteger64v;
+
+/* a horizontal run of live cells, this is how run-length encoded patterns
+   are handed to the GPU instead of expanding them into an image first */
+typedef struct CellRun {
+	int row;
+	int start;
+	int length;
+} CellRun;
+
+typedef struct CellRuns {
+	CellRun *runs;
+	size_t count;
+	size_t capacity;
+	/* the size of the pattern, runs are clipped to it */
+	int width;
+	int height;
+} CellRuns;
+
+/* a pattern packed into 32 cell columns exactly like the cell textures, so
+   a 1/8 byte per cell. columnsX x columnsY words, row by row */
+typedef struct PackedCells {
+	int width;
+	int height;
+	int columnsX;
+	int columnsY;
+	uint32_t *columns;
+} PackedCells;
 
 /* the vertex shader is shared between the render and update shaders */
 const char *vertShaderSource =
@@ -156,6 +262,50 @@ const char *updateShaderSource =
 	"	newCells = (~a & b & c) | (n11 & a & ~b & ~c);\n"
 	"}";
 
+/* the run shaders rasterize a list of cell runs straight into the packed cell texture. every
+   run is drawn as a horizontal line through the middle of its row of cell columns, and each
+   fragment ors in the single bit for the run's row with the logic op enabled */
+const char *runVertShaderSource =
+	"#version 130\n"
+	"in ivec2 position;\n"
+	"flat out int row;\n"
+	"uniform ivec2 numCells;\n"
+	"void main() {\n"
+	"	row = position.y;\n"
+	"	vec2 p = vec2(float(position.x) + 0.5, float(position.y / 32) + 0.5);\n"
+	"	p /= vec2(numCells.x, numCells.y / 32);\n"
+	"	gl_Position = vec4(2.0 * p - 1.0, 0.0, 1.0);\n"
+	"}";
+
+const char *runFragShaderSource =
+	"#version 130\n"
+	"flat in int row;\n"
+	"out uint newCells;\n"
+	"void main() {\n"
+	"	newCells = 1u << uint(row % 32);\n"
+	"}";
+
+/* the hud shaders draw flat colored rectangles given in window pixels from the top left */
+const char *hudVertShaderSource =
+	"#version 130\n"
+	"in vec2 position;\n"
+	"in vec4 color;\n"
+	"out vec4 rectColor;\n"
+	"uniform vec2 windowSize;\n"
+	"void main() {\n"
+	"	rectColor = color;\n"
+	"	vec2 p = 2.0 * position / windowSize - 1.0;\n"
+	"	gl_Position = vec4(p.x, -p.y, 0.0, 1.0);\n"
+	"}";
+
+const char *hudFragShaderSource =
+	"#version 130\n"
+	"in vec4 rectColor;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = rectColor;\n"
+	"}";
+
 #ifndef NDEBUG
 #define glCheckErrors()\
 	do {\
@@ -177,6 +327,835 @@ const char *updateShaderSource =
 #define glCheckErrors() do {} while(0)
 #endif /* !NDEBUG */
 
+/* just enough threading and file mapping to spread loading out over all cores,
+   with a windows and a posix version of everything */
+#ifdef _MSC_VER
+#define atomicFetchAdd(p, v) InterlockedExchangeAdd((volatile LONG *)(p), (LONG)(v))
+#define atomicOr(p, v) InterlockedOr((volatile LONG *)(p), (LONG)(v))
+#else
+#define atomicFetchAdd(p, v) __sync_fetch_and_add((p), (v))
+#define atomicOr(p, v) __sync_fetch_and_or((p), (v))
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+int countTrailingZeros64(uint64_t x) {
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (int)index;
+}
+#else
+#define countTrailingZeros64(x) __builtin_ctzll(x)
+#endif
+
+#define rotateLeft64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+/* a fast non-cryptographic 64-bit hash along the lines of xxhash, it runs
+   4 independent lanes at once so it can keep up with memory bandwidth */
+uint64_t hash64(const void *data, size_t size, uint64_t seed) {
+	const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t prime3 = 0x165667B19E3779F9ull;
+	const uint8_t *p = (const uint8_t *)data;
+	const uint8_t *end = p + size;
+	uint64_t lanes[4] = { seed + prime1 + prime2, seed + prime2, seed, seed - prime1 };
+	for (; end - p >= 32; p += 32) {
+		for (int i = 0; i < 4; ++i) {
+			uint64_t v;
+			memcpy(&v, p + 8 * i, sizeof(v));
+			lanes[i] += v * prime2;
+			lanes[i] = rotateLeft64(lanes[i], 31) * prime1;
+		}
+	}
+	uint64_t hash = rotateLeft64(lanes[0], 1) + rotateLeft64(lanes[1], 7) +
+		rotateLeft64(lanes[2], 12) + rotateLeft64(lanes[3], 18) + (uint64_t)size;
+	for (; end - p >= 8; p += 8) {
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		v *= prime2;
+		hash ^= rotateLeft64(v, 31) * prime1;
+		hash = rotateLeft64(hash, 27) * prime1 + prime3;
+	}
+	for (; p < end; ++p) {
+		hash ^= *p * 0x27D4EB2F165667C5ull;
+		hash = rotateLeft64(hash, 11) * prime1;
+	}
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+typedef struct ThreadStart {
+	void (*function)(void *arg);
+	void *arg;
+} ThreadStart;
+
+#ifdef _WIN32
+typedef HANDLE Thread;
+
+DWORD WINAPI threadMain(LPVOID param) {
+	ThreadStart start = *(ThreadStart *)param;
+	free(param);
+	start.function(start.arg);
+	return 0;
+}
+#else
+typedef pthread_t Thread;
+
+void *threadMain(void *param) {
+	ThreadStart start = *(ThreadStart *)param;
+	free(param);
+	start.function(start.arg);
+	return NULL;
+}
+#endif
+
+GLboolean startThread(Thread *thread, void (*function)(void *arg), void *arg) {
+	ThreadStart *start = (ThreadStart *)malloc(sizeof(ThreadStart));
+	if (!start)
+		return GL_FALSE;
+	start->function = function;
+	start->arg = arg;
+#ifdef _WIN32
+	*thread = CreateThread(NULL, 0, threadMain, start, 0, NULL);
+	if (*thread)
+		return GL_TRUE;
+#else
+	if (pthread_create(thread, NULL, threadMain, start) == 0)
+		return GL_TRUE;
+#endif
+	free(start);
+	return GL_FALSE;
+}
+
+void joinThread(Thread thread) {
+#ifdef _WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+}
+
+void sleepMilliseconds(int milliseconds) {
+#ifdef _WIN32
+	Sleep((DWORD)milliseconds);
+#else
+	struct timespec duration;
+	duration.tv_sec = milliseconds / 1000;
+	duration.tv_nsec = (long)(milliseconds % 1000) * 1000000L;
+	nanosleep(&duration, NULL);
+#endif
+}
+
+/* fails quietly if the directory is already there */
+void makeDirectory(const char *path) {
+#ifdef _WIN32
+	CreateDirectoryA(path, NULL);
+#else
+	mkdir(path, 0777);
+#endif
+}
+
+int getNumCores(void) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	int numCores = (int)info.dwNumberOfProcessors;
+#else
+	int numCores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (numCores < 1)
+		return 1;
+	if (numCores > 64)
+		return 64;
+	return numCores;
+}
+
+typedef struct ParallelFor {
+	void (*function)(void *arg, int index);
+	void *arg;
+	int count;
+	volatile int next;
+} ParallelFor;
+
+void parallelForWorker(void *param) {
+	ParallelFor *work = (ParallelFor *)param;
+	for (;;) {
+		int index = atomicFetchAdd(&work->next, 1);
+		if (index >= work->count)
+			break;
+		work->function(work->arg, index);
+	}
+}
+
+/* calls function(arg, i) for every i in [0, count) spread out over all cores, and
+   waits until they are all done. the calling thread does its share of the work too */
+void parallelFor(int count, void (*function)(void *arg, int index), void *arg) {
+	ParallelFor work;
+	work.function = function;
+	work.arg = arg;
+	work.count = count;
+	work.next = 0;
+
+	Thread threads[64];
+	int numThreads = getNumCores() - 1;
+	if (numThreads > count - 1)
+		numThreads = count - 1;
+	int numStarted = 0;
+	while (numStarted < numThreads && startThread(&threads[numStarted], parallelForWorker, &work))
+		++numStarted;
+	parallelForWorker(&work);
+	for (int i = 0; i < numStarted; ++i)
+		joinThread(threads[i]);
+}
+
+/* hands numbered items from the main thread over to worker threads without locks. item i goes
+   in slot i % number of slots, the main thread queues them in order and the workers take them
+   in order, and a slot can be reused once the item in it is done */
+typedef struct Handoff {
+	volatile int numQueued;
+	volatile int numTaken;
+	volatile int numDone;
+	volatile int isStopping;
+} Handoff;
+
+void resetHandoff(Handoff *handoff) {
+	handoff->numQueued = handoff->numTaken = handoff->numDone = handoff->isStopping = 0;
+}
+
+/* for a single worker, where items are done in order. with more workers, items can be done
+   out of order so they have to keep track of the slots themselves */
+GLboolean isHandoffFull(Handoff *handoff, int numSlots) {
+	return handoff->numQueued - atomicFetchAdd(&handoff->numDone, 0) >= numSlots;
+}
+
+void waitForHandoffSlot(Handoff *handoff, int numSlots) {
+	while (isHandoffFull(handoff, numSlots))
+		sleepMilliseconds(1);
+}
+
+void queueHandoffItem(Handoff *handoff) {
+	atomicFetchAdd(&handoff->numQueued, 1);
+}
+
+/* waits for the next item and returns its number, or -1 once the handoff is stopped and
+   every item has been taken */
+int takeHandoffItem(Handoff *handoff, int sleepTime) {
+	int item = atomicFetchAdd(&handoff->numTaken, 1);
+	while (item >= atomicFetchAdd(&handoff->numQueued, 0)) {
+		/* everything is queued before stopping, so one last look is enough */
+		if (atomicFetchAdd(&handoff->isStopping, 0) && item >= atomicFetchAdd(&handoff->numQueued, 0))
+			return -1;
+		sleepMilliseconds(sleepTime);
+	}
+	return item;
+}
+
+void finishHandoffItem(Handoff *handoff) {
+	atomicFetchAdd(&handoff->numDone, 1);
+}
+
+/* the workers finish off whatever is queued and then stop */
+void stopHandoff(Handoff *handoff) {
+	atomicFetchAdd(&handoff->isStopping, 1);
+}
+
+typedef struct MappedFile {
+	const char *data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+} MappedFile;
+
+/* maps a whole file read-only into memory, empty files can't be mapped */
+GLboolean mapFile(MappedFile *mapped, const char *path) {
+	mapped->data = NULL;
+	mapped->size = 0;
+#ifdef _WIN32
+	mapped->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mapped->file == INVALID_HANDLE_VALUE)
+		return GL_FALSE;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mapped->file, &size) || size.QuadPart == 0 || (uint64_t)size.QuadPart > (size_t)-1) {
+		CloseHandle(mapped->file);
+		return GL_FALSE;
+	}
+	mapped->mapping = CreateFileMappingA(mapped->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapped->mapping) {
+		CloseHandle(mapped->file);
+		return GL_FALSE;
+	}
+	mapped->data = (const char *)MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!mapped->data) {
+		CloseHandle(mapped->mapping);
+		CloseHandle(mapped->file);
+		return GL_FALSE;
+	}
+	mapped->size = (size_t)size.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return GL_FALSE;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size <= 0 || (uint64_t)info.st_size > (size_t)-1) {
+		close(fd);
+		return GL_FALSE;
+	}
+	void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return GL_FALSE;
+	mapped->data = (const char *)data;
+	mapped->size = (size_t)info.st_size;
+#endif
+	return GL_TRUE;
+}
+
+void unmapFile(MappedFile *mapped) {
+	if (!mapped->data)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(mapped->data);
+	CloseHandle(mapped->mapping);
+	CloseHandle(mapped->file);
+#else
+	munmap((void *)mapped->data, mapped->size);
+#endif
+	mapped->data = NULL;
+	mapped->size = 0;
+}
+
+uint32_t crcTable[256];
+
+void initCrcTable(void) {
+	for (uint32_t n = 0; n < 256; ++n) {
+		uint32_t c = n;
+		for (int k = 0; k < 8; ++k)
+			c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		crcTable[n] = c;
+	}
+}
+
+uint32_t updateCrc(uint32_t crc, const uint8_t *data, size_t size) {
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+		crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+/* gzip files are inflated as they're read, with nothing more than the 32k window of deflate
+   and a small input buffer in memory. huffman codes of up to INFLATE_FAST_BITS bits are
+   decoded with one table lookup, longer ones a bit at a time like zlib's puff does */
+#define INFLATE_WINDOW_SIZE (1 << 15)
+#define INFLATE_INPUT_SIZE (1 << 14)
+#define INFLATE_FAST_BITS 10
+
+typedef struct Huffman {
+	/* symbol << 4 | length for every code that fits, indexed by the next bits of input */
+	uint16_t fast[1 << INFLATE_FAST_BITS];
+	uint16_t counts[16];
+	uint16_t symbols[288];
+} Huffman;
+
+typedef enum InflateState {
+	INFLATE_MEMBER,
+	INFLATE_BLOCK,
+	INFLATE_STORED,
+	INFLATE_CODES,
+	INFLATE_DONE,
+	INFLATE_ERROR
+} InflateState;
+
+typedef struct Inflater {
+	FILE *f;
+	uint8_t input[INFLATE_INPUT_SIZE];
+	size_t inputPosition;
+	size_t inputSize;
+	uint64_t bits;
+	int numBits;
+	GLboolean isTruncated;
+	InflateState state;
+	GLboolean isLastBlock;
+	uint32_t storedLength;
+	int matchLength;
+	int matchDistance;
+	uint8_t window[INFLATE_WINDOW_SIZE];
+	uint32_t windowPosition;
+	GLboolean isWindowFull;
+	/* crc and size of what the current gzip member has inflated to so far */
+	uint32_t crc;
+	uint32_t memberSize;
+	Huffman lengths;
+	Huffman distances;
+} Inflater;
+
+const uint16_t inflateLengthBase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t inflateLengthExtra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t inflateDistanceBase[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t inflateDistanceExtra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+int readInflateByte(Inflater *inf) {
+	if (inf->inputPosition == inf->inputSize) {
+		inf->inputSize = fread(inf->input, 1, sizeof(inf->input), inf->f);
+		inf->inputPosition = 0;
+		if (inf->inputSize == 0)
+			return -1;
+	}
+	return inf->input[inf->inputPosition++];
+}
+
+/* running out of input in the middle of a member pads it with zeros and flags it as broken */
+void needBits(Inflater *inf, int count) {
+	while (inf->numBits < count) {
+		int c = readInflateByte(inf);
+		if (c < 0) {
+			inf->isTruncated = GL_TRUE;
+			c = 0;
+		}
+		inf->bits |= (uint64_t)c << inf->numBits;
+		inf->numBits += 8;
+	}
+}
+
+uint32_t getBits(Inflater *inf, int count) {
+	needBits(inf, count);
+	uint32_t value = (uint32_t)(inf->bits & ((1ull << count) - 1));
+	inf->bits >>= count;
+	inf->numBits -= count;
+	return value;
+}
+
+GLboolean buildHuffman(Huffman *huffman, const uint8_t *lengths, int count) {
+	memset(huffman->counts, 0, sizeof(huffman->counts));
+	for (int i = 0; i < count; ++i)
+		++huffman->counts[lengths[i]];
+	huffman->counts[0] = 0;
+
+	/* over-subscribed sets of lengths are broken, incomplete ones are allowed */
+	int left = 1;
+	uint16_t offsets[16];
+	offsets[1] = 0;
+	for (int length = 1; length < 16; ++length) {
+		left = 2 * left - huffman->counts[length];
+		if (left < 0)
+			return GL_FALSE;
+		if (length < 15)
+			offsets[length + 1] = offsets[length] + huffman->counts[length];
+	}
+
+	memset(huffman->fast, 0, sizeof(huffman->fast));
+	uint32_t nextCode[16];
+	uint32_t code = 0;
+	for (int length = 1; length < 16; ++length) {
+		code = (code + huffman->counts[length - 1]) << 1;
+		nextCode[length] = code;
+	}
+	for (int symbol = 0; symbol < count; ++symbol) {
+		int length = lengths[symbol];
+		if (length == 0)
+			continue;
+		huffman->symbols[offsets[length]++] = (uint16_t)symbol;
+		uint32_t symbolCode = nextCode[length]++;
+		if (length > INFLATE_FAST_BITS)
+			continue;
+		/* codes go into the stream most significant bit first */
+		uint32_t reversed = 0;
+		for (int i = 0; i < length; ++i)
+			reversed |= ((symbolCode >> i) & 1) << (length - 1 - i);
+		for (uint32_t i = reversed; i < (1u << INFLATE_FAST_BITS); i += 1u << length)
+			huffman->fast[i] = (uint16_t)(symbol << 4 | length);
+	}
+	return GL_TRUE;
+}
+
+int decodeSymbol(Inflater *inf, const Huffman *huffman) {
+	needBits(inf, INFLATE_FAST_BITS);
+	uint16_t entry = huffman->fast[inf->bits & ((1u << INFLATE_FAST_BITS) - 1)];
+	if (entry) {
+		getBits(inf, entry & 15);
+		return entry >> 4;
+	}
+	int code = 0, first = 0, index = 0;
+	for (int length = 1; length < 16; ++length) {
+		code |= (int)getBits(inf, 1);
+		int count = huffman->counts[length];
+		if (code - first < count)
+			return huffman->symbols[index + code - first];
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+	return -1;
+}
+
+GLboolean readFixedTables(Inflater *inf) {
+	uint8_t lengths[288];
+	for (int i = 0; i < 288; ++i)
+		lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+	buildHuffman(&inf->lengths, lengths, 288);
+	for (int i = 0; i < 30; ++i)
+		lengths[i] = 5;
+	return buildHuffman(&inf->distances, lengths, 30);
+}
+
+GLboolean readDynamicTables(Inflater *inf) {
+	const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+	int numLengths = (int)getBits(inf, 5) + 257;
+	int numDistances = (int)getBits(inf, 5) + 1;
+	int numCodeLengths = (int)getBits(inf, 4) + 4;
+	if (numLengths > 286 || numDistances > 30)
+		return GL_FALSE;
+
+	uint8_t lengths[288 + 32];
+	memset(lengths, 0, 19);
+	for (int i = 0; i < numCodeLengths; ++i)
+		lengths[order[i]] = (uint8_t)getBits(inf, 3);
+	if (!buildHuffman(&inf->lengths, lengths, 19))
+		return GL_FALSE;
+
+	for (int i = 0; i < numLengths + numDistances; ) {
+		int symbol = decodeSymbol(inf, &inf->lengths);
+		int repeat;
+		uint8_t length = 0;
+		if (symbol < 0) {
+			return GL_FALSE;
+		} else if (symbol < 16) {
+			lengths[i++] = (uint8_t)symbol;
+			continue;
+		} else if (symbol == 16) {
+			if (i == 0)
+				return GL_FALSE;
+			length = lengths[i - 1];
+			repeat = 3 + (int)getBits(inf, 2);
+		} else if (symbol == 17) {
+			repeat = 3 + (int)getBits(inf, 3);
+		} else {
+			repeat = 11 + (int)getBits(inf, 7);
+		}
+		if (i + repeat > numLengths + numDistances)
+			return GL_FALSE;
+		while (repeat-- > 0)
+			lengths[i++] = length;
+	}
+	if (lengths[256] == 0)
+		return GL_FALSE;
+	return buildHuffman(&inf->lengths, lengths, numLengths) &&
+		buildHuffman(&inf->distances, lengths + numLengths, numDistances);
+}
+
+/* false at the end of the file, or if what follows isn't another gzip member */
+GLboolean readGzipHeader(Inflater *inf) {
+	int id1 = inf->numBits >= 8 ? (int)getBits(inf, 8) : readInflateByte(inf);
+	if (id1 != 0x1F)
+		return GL_FALSE;
+	if (getBits(inf, 8) != 0x8B || getBits(inf, 8) != 8)
+		return GL_FALSE;
+	uint32_t flags = getBits(inf, 8);
+	getBits(inf, 32);
+	getBits(inf, 16);
+	if (flags & 0xE0)
+		return GL_FALSE;
+	if (flags & 4) {
+		uint32_t extraSize = getBits(inf, 16);
+		while (extraSize-- > 0 && !inf->isTruncated)
+			getBits(inf, 8);
+	}
+	for (int i = 3; i <= 4; ++i) {
+		/* zero terminated file name and comment */
+		if (flags & (1 << i))
+			while (getBits(inf, 8) != 0 && !inf->isTruncated);
+	}
+	if (flags & 2)
+		getBits(inf, 16);
+	return !inf->isTruncated;
+}
+
+/* the gzip file has to start at the current position, the first few bytes might already
+   have been read from it and are given back to the inflater in head */
+void initInflater(Inflater *inf, FILE *f, const uint8_t *head, size_t headSize) {
+	inf->f = f;
+	memcpy(inf->input, head, headSize);
+	inf->inputPosition = 0;
+	inf->inputSize = headSize;
+	inf->bits = 0;
+	inf->numBits = 0;
+	inf->isTruncated = GL_FALSE;
+	inf->state = INFLATE_MEMBER;
+	inf->matchLength = 0;
+	inf->windowPosition = 0;
+}
+
+/* inflates up to size bytes, less only at the end or on an error */
+size_t inflateGzip(Inflater *inf, uint8_t *out, size_t size) {
+	size_t n = 0;
+	size_t crcStart = 0;
+	while (n < size && inf->state != INFLATE_DONE && inf->state != INFLATE_ERROR) {
+		if (inf->matchLength > 0) {
+			uint32_t from = inf->windowPosition - (uint32_t)inf->matchDistance;
+			while (inf->matchLength > 0 && n < size) {
+				uint8_t c = inf->window[from++ & (INFLATE_WINDOW_SIZE - 1)];
+				inf->window[inf->windowPosition++ & (INFLATE_WINDOW_SIZE - 1)] = c;
+				out[n++] = c;
+				--inf->matchLength;
+			}
+			continue;
+		}
+
+		switch (inf->state) {
+		case INFLATE_MEMBER:
+			if (!readGzipHeader(inf)) {
+				inf->state = INFLATE_DONE;
+				break;
+			}
+			inf->crc = 0;
+			inf->memberSize = 0;
+			inf->windowPosition = 0;
+			inf->isWindowFull = GL_FALSE;
+			inf->isLastBlock = GL_FALSE;
+			inf->state = INFLATE_BLOCK;
+			break;
+		case INFLATE_BLOCK:
+			if (inf->isLastBlock) {
+				/* the member ends with the crc and size of what it inflated to */
+				inf->crc = updateCrc(inf->crc, out + crcStart, n - crcStart);
+				inf->memberSize += (uint32_t)(n - crcStart);
+				crcStart = n;
+				getBits(inf, inf->numBits & 7);
+				uint32_t crc = getBits(inf, 32);
+				uint32_t memberSize = getBits(inf, 32);
+				inf->state = crc == inf->crc && memberSize == inf->memberSize ? INFLATE_MEMBER : INFLATE_ERROR;
+				break;
+			}
+			inf->isLastBlock = getBits(inf, 1) != 0;
+			switch (getBits(inf, 2)) {
+			case 0:
+				getBits(inf, inf->numBits & 7);
+				inf->storedLength = getBits(inf, 16);
+				inf->state = getBits(inf, 16) == (~inf->storedLength & 0xFFFF) ? INFLATE_STORED : INFLATE_ERROR;
+				break;
+			case 1:
+				inf->state = readFixedTables(inf) ? INFLATE_CODES : INFLATE_ERROR;
+				break;
+			case 2:
+				inf->state = readDynamicTables(inf) ? INFLATE_CODES : INFLATE_ERROR;
+				break;
+			default:
+				inf->state = INFLATE_ERROR;
+				break;
+			}
+			break;
+		case INFLATE_STORED:
+			while (inf->storedLength > 0 && n < size) {
+				uint8_t c = (uint8_t)getBits(inf, 8);
+				inf->window[inf->windowPosition++ & (INFLATE_WINDOW_SIZE - 1)] = c;
+				out[n++] = c;
+				--inf->storedLength;
+			}
+			if (inf->storedLength == 0)
+				inf->state = INFLATE_BLOCK;
+			break;
+		case INFLATE_CODES:
+			while (n < size && inf->matchLength == 0) {
+				int symbol = decodeSymbol(inf, &inf->lengths);
+				if (symbol < 256) {
+					if (symbol < 0) {
+						inf->state = INFLATE_ERROR;
+						break;
+					}
+					inf->window[inf->windowPosition++ & (INFLATE_WINDOW_SIZE - 1)] = (uint8_t)symbol;
+					out[n++] = (uint8_t)symbol;
+					continue;
+				}
+				if (symbol == 256) {
+					inf->state = INFLATE_BLOCK;
+					break;
+				}
+				symbol -= 257;
+				if (symbol >= 29) {
+					inf->state = INFLATE_ERROR;
+					break;
+				}
+				inf->matchLength = inflateLengthBase[symbol] + (int)getBits(inf, inflateLengthExtra[symbol]);
+				int distance = decodeSymbol(inf, &inf->distances);
+				if (distance < 0 || distance >= 30) {
+					inf->state = INFLATE_ERROR;
+					break;
+				}
+				inf->matchDistance = inflateDistanceBase[distance] + (int)getBits(inf, inflateDistanceExtra[distance]);
+				inf->isWindowFull |= inf->windowPosition >= INFLATE_WINDOW_SIZE;
+				if (!inf->isWindowFull && (uint32_t)inf->matchDistance > inf->windowPosition) {
+					inf->state = INFLATE_ERROR;
+					break;
+				}
+			}
+			break;
+		default:
+			break;
+		}
+		if (inf->isTruncated)
+			inf->state = INFLATE_ERROR;
+	}
+	inf->crc = updateCrc(inf->crc, out + crcStart, n - crcStart);
+	inf->memberSize += (uint32_t)(n - crcStart);
+	return n;
+}
+
+/* pattern files are read through a stream, so every file is opened once whatever format it
+   turns out to be. the start of the file is buffered before anything is read, so formats can
+   be sniffed at without seeking back. readers that want the whole file at once get a mapping.
+   gzipped files are inflated on the way in, so every format can also be read compressed */
+#define STREAM_BUFFER_SIZE (1 << 16)
+
+typedef struct Stream {
+	const char *path;
+	FILE *f;
+	Inflater *inflater;
+	char *buffer;
+	size_t position;
+	size_t size;
+	/* how much of the file came before the start of the buffer */
+	uint64_t offset;
+	GLboolean isMappable;
+	MappedFile mapped;
+	char *contents;
+} Stream;
+
+/* tops the buffer up as far as it goes, keeping what hasn't been read yet */
+size_t fillStream(Stream *stream) {
+	if (stream->position > 0) {
+		stream->size -= stream->position;
+		memmove(stream->buffer, stream->buffer + stream->position, stream->size);
+		stream->offset += stream->position;
+		stream->position = 0;
+	}
+	size_t bytesRead;
+	while (stream->size < STREAM_BUFFER_SIZE) {
+		char *buffer = stream->buffer + stream->size;
+		size_t size = STREAM_BUFFER_SIZE - stream->size;
+		bytesRead = stream->inflater ? inflateGzip(stream->inflater, (uint8_t *)buffer, size) : fread(buffer, 1, size, stream->f);
+		if (bytesRead == 0)
+			break;
+		stream->size += bytesRead;
+	}
+	return stream->size;
+}
+
+GLboolean openStream(Stream *stream, const char *path) {
+	memset(stream, 0, sizeof(*stream));
+	stream->path = path;
+	stream->f = fopen(path, "rb");
+	stream->buffer = (char *)malloc(STREAM_BUFFER_SIZE);
+	if (!stream->f || !stream->buffer) {
+		if (stream->f)
+			fclose(stream->f);
+		free(stream->buffer);
+		return GL_FALSE;
+	}
+
+	uint8_t magic[2];
+	size_t magicSize = fread(magic, 1, sizeof(magic), stream->f);
+	if (magicSize == 2 && magic[0] == 0x1F && magic[1] == 0x8B) {
+		stream->inflater = (Inflater *)malloc(sizeof(Inflater));
+		if (!stream->inflater) {
+			fclose(stream->f);
+			free(stream->buffer);
+			return GL_FALSE;
+		}
+		initInflater(stream->inflater, stream->f, magic, magicSize);
+	} else {
+		memcpy(stream->buffer, magic, magicSize);
+		stream->size = magicSize;
+	}
+	stream->isMappable = !stream->inflater;
+	fillStream(stream);
+	return GL_TRUE;
+}
+
+GLboolean isStreamBroken(const Stream *stream) {
+	return stream->inflater && stream->inflater->state == INFLATE_ERROR;
+}
+
+void closeStream(Stream *stream) {
+	fclose(stream->f);
+	free(stream->inflater);
+	free(stream->buffer);
+	unmapFile(&stream->mapped);
+	free(stream->contents);
+}
+
+/* hands out whatever is buffered in one piece and marks it as read, false at the end */
+GLboolean readStreamBlock(Stream *stream, const char **start, const char **end) {
+	if (stream->position == stream->size && fillStream(stream) == 0)
+		return GL_FALSE;
+	*start = stream->buffer + stream->position;
+	*end = stream->buffer + stream->size;
+	stream->position = stream->size;
+	return GL_TRUE;
+}
+
+/* like fgets, except that the rest of a line too long for it is skipped */
+GLboolean readStreamLine(Stream *stream, char *line, size_t size) {
+	size_t length = 0;
+	for (;;) {
+		if (stream->position == stream->size && fillStream(stream) == 0)
+			break;
+		char c = stream->buffer[stream->position++];
+		if (length + 1 < size)
+			line[length++] = c;
+		if (c == '\n')
+			break;
+	}
+	line[length] = '\0';
+	return length > 0;
+}
+
+/* everything from the current position to the end of the file */
+const char *getStreamContents(Stream *stream, size_t *size) {
+	uint64_t position = stream->offset + stream->position;
+	if (stream->isMappable && (stream->mapped.data || mapFile(&stream->mapped, stream->path)) && position <= stream->mapped.size) {
+		*size = stream->mapped.size - (size_t)position;
+		return stream->mapped.data + position;
+	}
+
+	/* whatever can't be mapped is read into memory */
+	size_t capacity = 2 * STREAM_BUFFER_SIZE;
+	size_t length = 0;
+	char *contents = NULL;
+	const char *start, *end;
+	while (readStreamBlock(stream, &start, &end)) {
+		if ((size_t)(end - start) > capacity - length || !contents) {
+			while ((size_t)(end - start) > capacity - length)
+				capacity *= 2;
+			char *newContents = (char *)realloc(contents, capacity);
+			if (!newContents) {
+				free(contents);
+				return NULL;
+			}
+			contents = newContents;
+		}
+		memcpy(contents + length, start, (size_t)(end - start));
+		length += (size_t)(end - start);
+	}
+	free(stream->contents);
+	stream->contents = contents ? contents : (char *)malloc(1);
+	*size = length;
+	return stream->contents;
+}
+
 GLuint compileShader(GLenum type, const char *source) {
 	GLuint shader = glCreateShader(type);
 	if (!shader) {
@@ -344,9 +1323,9 @@ void updateCells(void) {
 	glCheckErrors();
 }
 
-void renderCells(void) {
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-	glViewport(0, 0, windowWidth, windowHeight);
+void renderCellsTo(GLuint framebuffer, int width, int height) {
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
 	glUseProgram(renderProgram);
 	glBindTexture(GL_TEXTURE_2D, cellsRead);
 	glUniform2f(uniformScale, scale * scaleX, scale * scaleY);
@@ -359,6 +1338,10 @@ void renderCells(void) {
 	glCheckErrors();
 }
 
+void renderCells(void) {
+	renderCellsTo(0, windowWidth, windowHeight);
+}
+
 void centerCellsOnScreen(void) {
 	scale = 1.0f;
 	scaleX = 1.0f;
@@ -384,448 +1367,5524 @@ void centerCellsOnScreen(void) {
 	}
 }
 
-void setCells(uint8_t *cells, int width, int height) {	
+/* images are alive where they're dark. bit i of the result is set if pixel i is no brighter than threshold */
+uint32_t findDarkPixels16(const uint8_t *pixels, uint8_t threshold) {
+#ifdef HAS_SSE2
+	__m128i row = _mm_loadu_si128((const __m128i *)pixels);
+	__m128i brightness = _mm_subs_epu8(row, _mm_set1_epi8((char)threshold));
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(brightness, _mm_setzero_si128()));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < 16; ++i)
+		mask |= (uint32_t)(pixels[i] <= threshold) << i;
+	return mask;
+#endif
+}
+
+/* transposes a 32x32 bit matrix in place, bit j of word i ends up as bit i of word j */
+void transpose32(uint32_t words[32]) {
+	uint32_t mask = 0x0000FFFF;
+	for (int j = 16; j != 0; j >>= 1, mask ^= mask << j) {
+		for (int k = 0; k < 32; k = (k + j + 1) & ~j) {
+			uint32_t t = ((words[k] >> j) ^ words[k + j]) & mask;
+			words[k] ^= t << j;
+			words[k + j] ^= t;
+		}
+	}
+}
+
+/* images are packed 32x32 pixels at a time: 32 rows of 32 pixels are turned into bits and then
+   transposed into 32 column words. bands of 32 rows are spread out over all cores */
+typedef struct RowPacker {
+	const uint8_t *firstRow;
+	ptrdiff_t stride;
+	int width;
+	int height;
+	uint8_t threshold;
+	GLboolean isBitmap;
+	PackedCells *cells;
+} RowPacker;
+
+/* bit i of the result is set if pixel x + i of row is alive. bitmap rows have the first pixel in
+   the high bit of the first byte and set bits are black, as in PBM files */
+uint32_t getRowPixels32(const RowPacker *packer, const uint8_t *row, int x) {
+	int numPixels = packer->width - x < 32 ? packer->width - x : 32;
+	uint32_t mask = 0;
+	if (packer->isBitmap) {
+		memcpy(&mask, row + x / 8, (size_t)(numPixels + 7) / 8);
+		mask = ((mask & 0xF0F0F0F0u) >> 4) | ((mask & 0x0F0F0F0Fu) << 4);
+		mask = ((mask & 0xCCCCCCCCu) >> 2) | ((mask & 0x33333333u) << 2);
+		mask = ((mask & 0xAAAAAAAAu) >> 1) | ((mask & 0x55555555u) << 1);
+	} else if (numPixels == 32) {
+		return findDarkPixels16(row + x, packer->threshold) | (findDarkPixels16(row + x + 16, packer->threshold) << 16);
+	} else {
+		for (int i = 0; i < numPixels; ++i)
+			mask |= (uint32_t)(row[x + i] <= packer->threshold) << i;
+	}
+	/* the padding bits at the end of a bitmap row can be anything */
+	return numPixels == 32 ? mask : mask & ((1u << numPixels) - 1);
+}
+
+void packRowBand(void *arg, int columnY) {
+	const RowPacker *packer = (const RowPacker *)arg;
+	uint32_t *cellColumns = &packer->cells->columns[(size_t)columnY * (size_t)packer->cells->columnsX];
+	int numRows = packer->height - 32 * columnY < 32 ? packer->height - 32 * columnY : 32;
+	for (int x = 0; x < packer->width; x += 32) {
+		uint32_t block[32];
+		uint32_t any = 0;
+		for (int i = 0; i < 32; ++i) {
+			const uint8_t *row = packer->firstRow + (ptrdiff_t)(32 * columnY + i) * packer->stride;
+			block[i] = i < numRows ? getRowPixels32(packer, row, x) : 0;
+			any |= block[i];
+		}
+		if (!any)
+			continue;
+		transpose32(block);
+		memcpy(&cellColumns[x], block, sizeof(block));
+	}
+}
+
+/* packs an image into cells, which must be cleared. row y of the world is firstRow + y * stride,
+   so a negative stride packs an image that is stored top down */
+void packRows(const uint8_t *firstRow, ptrdiff_t stride, int width, int height, uint8_t threshold, GLboolean isBitmap, PackedCells *cells) {
+	RowPacker packer;
+	packer.firstRow = firstRow;
+	packer.stride = stride;
+	packer.width = width;
+	packer.height = height;
+	packer.threshold = threshold;
+	packer.isBitmap = isBitmap;
+	packer.cells = cells;
+	parallelFor(cells->columnsY, packRowBand, &packer);
+}
+
+/* resizes both cell textures to fit a width x height pattern and clears them */
+GLboolean resizeCells(int width, int height) {
 	int w = ceilMultipleOf32(width);
 	int h = ceilMultipleOf32(height);
 	
 	if (w < 1 || h < 1) {
 		fprintf(stderr, "ERROR: invalid pattern size %d x %d .. ignoring\n", w, h);
-		return;
+		return GL_FALSE;
 	}
 
 	if (w > maxTextureSize || h > maxTextureSize) {
 		fprintf(stderr, "ERROR: pattern size %d x %d is larger than maximum %d x %d .. ignoring\n",
 			w, h, maxTextureSize, maxTextureSize);
-		return;
+		return GL_FALSE;
 	}
 
 	numCellsX = w;
 	numCellsY = h;
 	int numCellColumnsY = numCellsY / 32;
-	size_t numCellColumns = (size_t)numCellsX * (size_t)numCellsY;
-	uint32_t *cellColumns = (uint32_t *)calloc(numCellColumns, sizeof(uint32_t));
-
-	for (int y = 0; y < height; ++y) {
-		uint32_t *cellColumn = &cellColumns[(y / 32) * numCellsX];
-		int cellColumnBit = y % 32;
-		const uint8_t *cellRow = &cells[y * width];
-		for (int x = 0; x < width; ++x) {
-			if (cellRow[x] != 0) {
-				cellColumn[x] |= (1 << cellColumnBit);
-			}
-		}
-	}
 
 	glBindTexture(GL_TEXTURE_2D, cellsWrite);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI,
 		(GLsizei)numCellsX, (GLsizei)numCellColumnsY, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
 	glBindTexture(GL_TEXTURE_2D, cellsRead);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI,
-		(GLsizei)numCellsX, (GLsizei)numCellColumnsY, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, cellColumns);
+		(GLsizei)numCellsX, (GLsizei)numCellColumnsY, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
 
-	generation = 0;
-	free(cellColumns);
-	centerCellsOnScreen();
+	/* start from an empty world, so that only live cells ever have to be uploaded */
+	const GLuint zero[4] = { 0, 0, 0, 0 };
+	glBindFramebuffer(GL_FRAMEBUFFER, cellsReadFramebuffer);
+	glClearBufferuiv(GL_COLOR, 0, zero);
+	return GL_TRUE;
 }
 
-void clearCells() {
-	setPatternName("unnamed pattern");
-	glBindFramebuffer(GL_FRAMEBUFFER, cellsReadFramebuffer);
-	/* this seems to work - even though the format is unsigned 
-	   integer and not floating point.. should look into glClearBuffer */
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
+/* uploads the whole world band by band, the cell textures must already be sized to it */
+void uploadCellBands(const PackedCells *cells) {
+	int numCellColumnsY = numCellsY / 32;
+	glBindTexture(GL_TEXTURE_2D, cellsRead);
+
+	/* instead of uploading the whole pattern in one blocking call, we copy each band into a
+	   mapped pixel buffer. the buffers are orphaned on every map, so the driver can keep
+	   transferring the previous band while we are already copying the next one. the world
+	   starts out empty, so bands without any live cells are skipped, which is checked on the
+	   packed cells since the mapping is write only */
+	size_t rowSize = (size_t)numCellsX * sizeof(uint32_t);
+	int bandColumnsY = (int)(UPLOAD_BAND_SIZE / rowSize);
+	if (bandColumnsY < 1)
+		bandColumnsY = 1;
+	if (bandColumnsY > numCellColumnsY)
+		bandColumnsY = numCellColumnsY;
+
+	for (int y = 0; y < numCellColumnsY; y += bandColumnsY) {
+		int numColumnsY = numCellColumnsY - y < bandColumnsY ? numCellColumnsY - y : bandColumnsY;
+		const uint32_t *columns = &cells->columns[(size_t)y * (size_t)numCellsX];
+		size_t numColumns = (size_t)numColumnsY * (size_t)numCellsX;
+		uint32_t live = 0;
+		for (size_t i = 0; i < numColumns && !live; ++i)
+			live |= columns[i];
+		if (!live)
+			continue;
+
+		size_t bandSize = numColumns * sizeof(uint32_t);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffers[nextUploadBuffer]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)bandSize, NULL, GL_STREAM_DRAW);
+		uint32_t *band = (uint32_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)bandSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (!band) {
+			fprintf(stderr, "ERROR: OpenGL failed to map %zu byte upload buffer .. aborting\n", bandSize);
+			abort();
+		}
+		memcpy(band, columns, bandSize);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, (GLsizei)numCellsX, (GLsizei)numColumnsY,
+			GL_RED_INTEGER, GL_UNSIGNED_INT, (const void *)0);
+		nextUploadBuffer = (nextUploadBuffer + 1) % NUM_UPLOAD_BUFFERS;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glCheckErrors();
+}
+
+void setPackedCells(const PackedCells *cells) {
+	if (!resizeCells(cells->width, cells->height))
+		return;
+
+	uploadCellBands(cells);
 	generation = 0;
+	centerCellsOnScreen();
 }
 
-void onGlfwError(int code, const char *desc) {
-	printf("GLFW error 0x%X: %s\n", code, desc);
+GLboolean allocPackedCells(PackedCells *cells, int width, int height) {
+	cells->width = width;
+	cells->height = height;
+	cells->columnsX = ceilMultipleOf32(width);
+	cells->columnsY = ceilMultipleOf32(height) / 32;
+	cells->columns = (uint32_t *)calloc((size_t)cells->columnsX * (size_t)cells->columnsY, sizeof(uint32_t));
+	return cells->columns != NULL;
 }
 
-void onFramebufferResized(GLFWwindow *window, int newWidth, int newHeight) {
-	glViewport(0, 0, newWidth, newHeight);
-	windowWidth = newWidth;
-	windowHeight = newHeight;
+void freePackedCells(PackedCells *cells) {
+	free(cells->columns);
+	cells->columns = NULL;
+}
+
+/* sets a horizontal run of cells, anything outside of the pattern is clipped */
+void setPackedRun(PackedCells *cells, int row, int start, int length) {
+	if (row < 0 || row >= cells->height)
+		return;
+	if (start < 0) {
+		length += start;
+		start = 0;
+	}
+	if (length > cells->width - start)
+		length = cells->width - start;
+
+	uint32_t bit = 1u << (row % 32);
+	uint32_t *column = &cells->columns[(size_t)(row / 32) * (size_t)cells->columnsX + (size_t)start];
+	for (int i = 0; i < length; ++i)
+		column[i] |= bit;
+}
+
+/* same as setPackedRun, but safe when other threads are setting cells in the same words */
+void setPackedRunAtomic(PackedCells *cells, int row, int start, int length) {
+	if (row < 0 || row >= cells->height)
+		return;
+	if (start < 0) {
+		length += start;
+		start = 0;
+	}
+	if (length > cells->width - start)
+		length = cells->width - start;
+
+	uint32_t bit = 1u << (row % 32);
+	uint32_t *column = &cells->columns[(size_t)(row / 32) * (size_t)cells->columnsX + (size_t)start];
+	for (int i = 0; i < length; ++i)
+		atomicOr(&column[i], bit);
+}
+
+/* adds a run to the list, clipped to the pattern like setPackedRun does */
+GLboolean appendCellRun(CellRuns *runs, int row, int start, int length) {
+	if (row < 0 || row >= runs->height)
+		return GL_TRUE;
+	if (start < 0) {
+		length += start;
+		start = 0;
+	}
+	if (length > runs->width - start)
+		length = runs->width - start;
+	if (length <= 0)
+		return GL_TRUE;
+
+	if (runs->count == runs->capacity) {
+		size_t capacity = runs->capacity ? 2 * runs->capacity : 4096;
+		CellRun *newRuns = (CellRun *)realloc(runs->runs, capacity * sizeof(CellRun));
+		if (!newRuns)
+			return GL_FALSE;
+		runs->runs = newRuns;
+		runs->capacity = capacity;
+	}
+	CellRun *run = &runs->runs[runs->count++];
+	run->row = row;
+	run->start = start;
+	run->length = length;
+	return GL_TRUE;
+}
+
+/* same as setCells but the pattern is given as a list of live cell runs, which
+   are uploaded in batches and rasterized into the cell texture on the GPU */
+void setCellRuns(const CellRuns *runs, int width, int height) {
+	if (!resizeCells(width, height))
+		return;
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cellsReadFramebuffer);
+	glViewport(0, 0, numCellsX, numCellsY / 32);
+	glUseProgram(runProgram);
+	glUniform2i(uniformRunNumCells, numCellsX, numCellsY);
+	glBindVertexArray(runVertexArray);
+	glEnable(GL_COLOR_LOGIC_OP);
+	glLogicOp(GL_OR);
+
+	/* each run becomes one line, so 2 vertices of 2 integers */
+	size_t batchSize = UPLOAD_BAND_SIZE / (4 * sizeof(GLint));
+	for (size_t i = 0; i < runs->count; i += batchSize) {
+		size_t numRuns = runs->count - i < batchSize ? runs->count - i : batchSize;
+		GLsizeiptr size = (GLsizeiptr)(numRuns * 4 * sizeof(GLint));
+		glBindBuffer(GL_ARRAY_BUFFER, uploadBuffers[nextUploadBuffer]);
+		glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+		GLint *vertices = (GLint *)glMapBufferRange(GL_ARRAY_BUFFER, 0, size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (!vertices) {
+			fprintf(stderr, "ERROR: OpenGL failed to map %zu byte upload buffer .. aborting\n", (size_t)size);
+			abort();
+		}
+
+		for (size_t j = 0; j < numRuns; ++j) {
+			const CellRun *run = &runs->runs[i + j];
+			vertices[4 * j + 0] = run->start;
+			vertices[4 * j + 1] = run->row;
+			vertices[4 * j + 2] = run->start + run->length;
+			vertices[4 * j + 3] = run->row;
+		}
+
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glVertexAttribIPointer(runPositionLocation, 2, GL_INT, 2 * sizeof(GLint), (void *)0);
+		glDrawArrays(GL_LINES, 0, (GLsizei)(2 * numRuns));
+		nextUploadBuffer = (nextUploadBuffer + 1) % NUM_UPLOAD_BUFFERS;
+	}
+
+	glDisable(GL_COLOR_LOGIC_OP);
+	glBindVertexArray(vertexArray);
+	glCheckErrors();
+
+	generation = 0;
 	centerCellsOnScreen();
 }
 
-void onMouseButton(GLFWwindow *window, int button, int action, int mods) {
-	if (action == GLFW_PRESS)
-		pressedButton = button;
-	else if (action == GLFW_RELEASE) {
-		if (button == pressedButton)
-			pressedButton = -1;
+/* synthetic worlds for reproducible performance testing. a world spec like soup:1000x777:0.35:42
+   gives the kind of world, its exact size, its density and a random seed, and the same spec
+   always makes the same cells however many cores it is spread over */
+typedef enum WorldKind {
+	WORLD_SOUP,
+	WORLD_ASH,
+	WORLD_GLIDERS,
+	WORLD_OSCILLATORS,
+	NUM_WORLD_KINDS
+} WorldKind;
+
+const char *worldKindNames[NUM_WORLD_KINDS] = { "soup", "ash", "gliders", "oscillators" };
+const double worldKindDensities[NUM_WORLD_KINDS] = { 0.5, 0.5, 0.1, 0.5 };
+
+typedef struct WorldSpec {
+	WorldKind kind;
+	int width;
+	int height;
+	double density;
+	uint64_t seed;
+} WorldSpec;
+
+/* the small objects that ash, glider and oscillator fields are scattered with, each drawn row by
+   row in a box big enough for all of its phases. ash weights are roughly how common each object
+   is in settled random soups */
+typedef struct WorldObject {
+	WorldKind kind;
+	int weight;
+	int width;
+	int height;
+	const char *cells;
+} WorldObject;
+
+const WorldObject worldObjects[] = {
+	{ WORLD_ASH, 34, 2, 2, "OOOO" },
+	{ WORLD_ASH, 31, 3, 3, "...OOO..." },
+	{ WORLD_ASH, 17, 4, 3, ".OO.O..O.OO." },
+	{ WORLD_ASH, 6, 4, 4, ".OO.O..O.O.O..O." },
+	{ WORLD_ASH, 6, 3, 3, "OO.O.O.O." },
+	{ WORLD_ASH, 2, 3, 3, ".O.O.O.O." },
+	{ WORLD_ASH, 2, 3, 3, "OO.O.O.OO" },
+	{ WORLD_ASH, 1, 4, 4, ".OO.O..OO..O.OO." },
+	{ WORLD_GLIDERS, 1, 3, 3, ".O...OOOO" },
+	{ WORLD_OSCILLATORS, 1, 3, 3, "...OOO..." },
+	{ WORLD_OSCILLATORS, 1, 4, 4, ".....OOOOOO....." },
+	{ WORLD_OSCILLATORS, 1, 4, 4, "OO..OO....OO..OO" },
+};
+
+/* objects are placed in 8 x 8 tiles, at most one each and never closer than 2 cells to the
+   next tile, so that ash and oscillators stay the way they are put down */
+#define WORLD_TILE_SIZE 8
+
+/* splitmix64, so that synthetic worlds come out the same on every machine */
+uint64_t nextRandom(uint64_t *state) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+/* parses kind:WxH[:density[:seed]], and returns false for anything else so it can be tried as a file */
+GLboolean parseWorldSpec(const char *text, WorldSpec *spec) {
+	int kind;
+	size_t length = 0;
+	for (kind = 0; kind < NUM_WORLD_KINDS; ++kind) {
+		length = strlen(worldKindNames[kind]);
+		if (strncmp(text, worldKindNames[kind], length) == 0 && text[length] == ':')
+			break;
+	}
+	if (kind == NUM_WORLD_KINDS)
+		return GL_FALSE;
+
+	const char *p = text + length + 1;
+	char *end;
+	long width = strtol(p, &end, 10);
+	if (end == p || *end != 'x')
+		return GL_FALSE;
+	p = end + 1;
+	long height = strtol(p, &end, 10);
+	if (end == p)
+		return GL_FALSE;
+	spec->kind = (WorldKind)kind;
+	spec->density = worldKindDensities[kind];
+	spec->seed = 1;
+	if (*end == ':')
+		spec->density = strtod(end + 1, &end);
+	if (*end == ':')
+		spec->seed = strtoull(end + 1, &end, 10);
+	if (*end != 0 || width < 1 || width > 1 << 20 || height < 1 || height > 1 << 20 || !(spec->density >= 0.0 && spec->density <= 1.0))
+		return GL_FALSE;
+	spec->width = (int)width;
+	spec->height = (int)height;
+	return GL_TRUE;
+}
+
+typedef struct WorldGenerator {
+	const WorldSpec *spec;
+	PackedCells *cells;
+	/* soup density as a binary fraction of 256, and the objects to scatter with their total weight */
+	int density256;
+	const WorldObject *objects[sizeof(worldObjects) / sizeof(worldObjects[0])];
+	int numObjects;
+	int totalWeight;
+} WorldGenerator;
+
+/* 64 random bits that are each set with a probability of density256 / 256. every binary digit of
+   the density, from the lowest set one up, ands or ors in another random word */
+uint64_t getSoupBits(int density256, uint64_t *random) {
+	if (density256 <= 0)
+		return 0;
+	if (density256 >= 256)
+		return ~0ull;
+	int digit = countTrailingZeros64((uint64_t)density256);
+	uint64_t bits = nextRandom(random);
+	for (++digit; digit < 8; ++digit)
+		bits = (density256 >> digit) & 1 ? bits | nextRandom(random) : bits & nextRandom(random);
+	return bits;
+}
+
+void stampWorldObject(PackedCells *cells, const WorldObject *object, int x0, int y0, uint64_t symmetry) {
+	for (int y = 0; y < object->height; ++y) {
+		for (int x = 0; x < object->width; ++x) {
+			if (object->cells[y * object->width + x] != 'O')
+				continue;
+			int u = symmetry & 1 ? object->width - 1 - x : x;
+			int v = symmetry & 2 ? object->height - 1 - y : y;
+			if (symmetry & 4) {
+				int t = u;
+				u = v;
+				v = t;
+			}
+			int row = y0 + v;
+			cells->columns[(size_t)(row / 32) * (size_t)cells->columnsX + (size_t)(x0 + u)] |= 1u << (row % 32);
+		}
+	}
+}
+
+/* fills one band of 32 rows, with a random stream of its own so bands can go in any order */
+void generateWorldBand(void *arg, int band) {
+	WorldGenerator *gen = (WorldGenerator *)arg;
+	const WorldSpec *spec = gen->spec;
+	PackedCells *cells = gen->cells;
+	uint64_t random = hash64(&band, sizeof(band), spec->seed);
+	uint32_t *columns = &cells->columns[(size_t)band * (size_t)cells->columnsX];
+	int bandHeight = spec->height - 32 * band < 32 ? spec->height - 32 * band : 32;
+
+	if (spec->kind == WORLD_SOUP) {
+		uint32_t mask = bandHeight == 32 ? ~0u : (1u << bandHeight) - 1;
+		for (int x = 0; x < spec->width; x += 2) {
+			uint64_t bits = getSoupBits(gen->density256, &random);
+			columns[x] = (uint32_t)bits & mask;
+			if (x + 1 < spec->width)
+				columns[x + 1] = (uint32_t)(bits >> 32) & mask;
+		}
 		return;
 	}
 
-	if (button != GLFW_MOUSE_BUTTON_LEFT && button != GLFW_MOUSE_BUTTON_RIGHT || keyModsArePressed())
+	/* tiles never straddle bands, so no other thread writes to these words */
+	uint64_t threshold = (uint64_t)(spec->density * 4294967296.0);
+	for (int tileY = 32 * band; tileY < 32 * band + bandHeight; tileY += WORLD_TILE_SIZE) {
+		for (int tileX = 0; tileX < spec->width; tileX += WORLD_TILE_SIZE) {
+			if ((nextRandom(&random) & 0xFFFFFFFFu) >= threshold)
+				continue;
+			uint64_t bits = nextRandom(&random);
+			int pick = (int)((bits & 0xFFFFFFFFu) % (uint64_t)gen->totalWeight);
+			int i = 0;
+			while (pick >= gen->objects[i]->weight)
+				pick -= gen->objects[i++]->weight;
+			const WorldObject *object = gen->objects[i];
+			uint64_t symmetry = bits >> 61;
+			int w = symmetry & 4 ? object->height : object->width;
+			int h = symmetry & 4 ? object->width : object->height;
+			int x0 = tileX + 1 + (int)(((bits >> 32) & 0xFFFF) % (uint64_t)(WORLD_TILE_SIZE - 1 - w));
+			int y0 = tileY + 1 + (int)(((bits >> 48) & 0x1FFF) % (uint64_t)(WORLD_TILE_SIZE - 1 - h));
+			if (x0 + w <= spec->width && y0 + h <= spec->height)
+				stampWorldObject(cells, object, x0, y0, symmetry);
+		}
+	}
+}
+
+GLboolean generateWorld(const WorldSpec *spec, PackedCells *cells) {
+	if (!allocPackedCells(cells, spec->width, spec->height))
+		return GL_FALSE;
+	WorldGenerator gen;
+	gen.spec = spec;
+	gen.cells = cells;
+	gen.density256 = (int)(spec->density * 256.0 + 0.5);
+	gen.numObjects = 0;
+	gen.totalWeight = 0;
+	for (int i = 0; i < (int)(sizeof(worldObjects) / sizeof(worldObjects[0])); ++i) {
+		if (worldObjects[i].kind == spec->kind) {
+			gen.objects[gen.numObjects++] = &worldObjects[i];
+			gen.totalWeight += worldObjects[i].weight;
+		}
+	}
+	parallelFor(cells->columnsY, generateWorldBand, &gen);
+	return GL_TRUE;
+}
+
+/* replaces the world with a synthetic one */
+void setWorld(const WorldSpec *spec) {
+	/* checked before generating, since a huge world takes a long time to generate only to be
+	   turned away by resizeCells */
+	if (spec->width > maxTextureSize || spec->height > maxTextureSize) {
+		fprintf(stderr, "ERROR: world size %d x %d is larger than maximum %d x %d .. ignoring\n",
+			spec->width, spec->height, maxTextureSize, maxTextureSize);
+		return;
+	}
+	printf("generating %s %d x %d, density %g, seed %llu .. ", worldKindNames[spec->kind],
+		spec->width, spec->height, spec->density, (unsigned long long)spec->seed);
+	PackedCells cells;
+	if (!generateWorld(spec, &cells)) {
+		fprintf(stderr, "ERROR: not enough memory for a %d x %d world .. ignoring\n", spec->width, spec->height);
 		return;
+	}
+	setPackedCells(&cells);
+	freePackedCells(&cells);
+	setPatternName(worldKindNames[spec->kind]);
+	printf("done\n");
+}
 
-	float mX = (float)(mouseX / windowWidth);
-	float mY = (float)(mouseY / windowHeight);
-	int x = (int)(numCellsX * (offsetX + mX * scaleX * scale));
-	int y = (int)(numCellsY * (offsetY + mY * scaleY * scale));
-	if (x >= 0 && x < numCellsX && y >= 0 && y < numCellsY) {
+/* incremental RLE body decoder, it keeps all of its state between calls so the file can
+   be fed through in arbitrarily sized pieces without caring where tokens are split. runs
+   of live cells go straight into packed cells, or into a run list for the GPU */
+typedef struct RleDecoder {
+	PackedCells *cells;
+	CellRuns *runs;
+	int width;
+	int cursorX;
+	int cursorY;
+	int runCount;
+	/* rows in these two bands of cell columns might be shared with other threads */
+	int sharedBandLo;
+	int sharedBandHi;
+	GLboolean isDone;
+	GLboolean isOk;
+	GLboolean isValid;
+} RleDecoder;
 
-		uint8_t value = 0;
-		if (button == GLFW_MOUSE_BUTTON_LEFT) {
-			value = 0xFF;
+void initRleDecoder(RleDecoder *decoder, PackedCells *cells, CellRuns *runs, int height) {
+	decoder->cells = cells;
+	decoder->runs = runs;
+	decoder->width = cells ? cells->width : runs->width;
+	decoder->cursorX = 0;
+	decoder->cursorY = height - 1;
+	decoder->runCount = 0;
+	decoder->sharedBandLo = -1;
+	decoder->sharedBandHi = -1;
+	decoder->isDone = GL_FALSE;
+	decoder->isOk = GL_TRUE;
+	decoder->isValid = GL_TRUE;
+}
+
+/* the cursor stops right past the pattern on both sides, nothing there is ever drawn and
+   it keeps huge runs in malformed files from overflowing it. cursorY never goes below -1 */
+void decodeRle(RleDecoder *decoder, const char *p, const char *end) {
+	int cursorX = decoder->cursorX;
+	int cursorY = decoder->cursorY;
+	int runCount = decoder->runCount;
+	for (; p < end && !decoder->isDone; ++p) {
+		char c = *p;
+		if (c >= '0' && c <= '9') {
+			if (runCount >= INT32_MAX / 10) {
+				decoder->isValid = GL_FALSE;
+				decoder->isDone = GL_TRUE;
+				break;
+			}
+			runCount = 10 * runCount + (c - '0');
+			continue;
 		}
 
-		uint32_t cellColumn;
-		glBindFramebuffer(GL_FRAMEBUFFER, cellsReadFramebuffer);
-		glReadPixels(x, y / 32, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &cellColumn);
-		if (value)
-			cellColumn |= (1 << (y & 31));
-		else
-			cellColumn &= ~(1 << (y & 31));
-		glBindTexture(GL_TEXTURE_2D, cellsRead);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y / 32, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &cellColumn);
+		int count = runCount ? runCount : 1;
+		if (c == 'b' || c == '.') {
+			cursorX = count < decoder->width - cursorX ? cursorX + count : decoder->width;
+		} else if (c == 'o' || (c >= 'A' && c <= 'X')) {
+			int band = cursorY / 32;
+			if (decoder->cells && (band == decoder->sharedBandLo || band == decoder->sharedBandHi))
+				setPackedRunAtomic(decoder->cells, cursorY, cursorX, count);
+			else if (decoder->cells)
+				setPackedRun(decoder->cells, cursorY, cursorX, count);
+			else
+				decoder->isOk &= appendCellRun(decoder->runs, cursorY, cursorX, count);
+			cursorX = count < decoder->width - cursorX ? cursorX + count : decoder->width;
+		} else if (c == '$') {
+			cursorY = count <= cursorY ? cursorY - count : -1;
+			cursorX = 0;
+		} else if (c == '!') {
+			decoder->isDone = GL_TRUE;
+		} else {
+			/* whitespace between tokens, and anything else we don't understand */
+			continue;
+		}
+		runCount = 0;
 	}
+	decoder->cursorX = cursorX;
+	decoder->cursorY = cursorY;
+	decoder->runCount = runCount;
 }
 
-void onMouseMove(GLFWwindow *window, double newX, double newY) {
-	newY = (double)windowHeight - newY;
-	double oldX = mouseX;
-	double oldY = mouseY;
-	double deltaX = newX - oldX;
-	double deltaY = newY - oldY;
-	mouseX = newX;
-	mouseY = newY;
+/* large RLE files are mapped into memory and cut into chunks right after '$' tokens, so
+   every chunk starts at the beginning of a row. the chunks are first scanned in parallel
+   to count how many rows each one advances by, a prefix sum of those gives the row every
+   chunk starts on, and then all chunks are decoded in parallel */
+#define RLE_CHUNK_SIZE (1 << 20)
+#define MAX_RLE_CHUNKS 4096
 
-	if (pressedButton != GLFW_MOUSE_BUTTON_LEFT && pressedButton != GLFW_MOUSE_BUTTON_RIGHT && pressedButton != GLFW_MOUSE_BUTTON_MIDDLE)
+typedef struct RleChunk {
+	const char *start;
+	const char *end;
+	int numRows;
+	int startRow;
+	GLboolean hasEnd;
+} RleChunk;
+
+typedef struct ParallelRle {
+	RleChunk chunks[MAX_RLE_CHUNKS];
+	int numChunks;
+	PackedCells *cells;
+	volatile int numInvalid;
+} ParallelRle;
+
+/* counts saturate, runs too long to be valid are caught once the chunk is decoded and
+   a chunk never needs to advance by more than the whole height */
+void countRleChunkRows(void *arg, int index) {
+	ParallelRle *rle = (ParallelRle *)arg;
+	RleChunk *chunk = &rle->chunks[index];
+	int height = rle->cells->height;
+	int numRows = 0;
+	int runCount = 0;
+	for (const char *p = chunk->start; p < chunk->end; ++p) {
+		char c = *p;
+		if (c >= '0' && c <= '9') {
+			if (runCount < INT32_MAX / 10)
+				runCount = 10 * runCount + (c - '0');
+		} else if (c == '$') {
+			int count = runCount ? runCount : 1;
+			numRows = count < height - numRows ? numRows + count : height;
+			runCount = 0;
+		} else if (c == '!') {
+			chunk->end = p + 1;
+			chunk->hasEnd = GL_TRUE;
+			break;
+		} else if (c > ' ') {
+			runCount = 0;
+		}
+	}
+	chunk->numRows = numRows;
+}
+
+void decodeRleChunk(void *arg, int index) {
+	ParallelRle *rle = (ParallelRle *)arg;
+	RleChunk *chunk = &rle->chunks[index];
+	RleDecoder decoder;
+	initRleDecoder(&decoder, rle->cells, NULL, 0);
+	decoder.cursorY = chunk->startRow;
+	decoder.sharedBandHi = chunk->startRow / 32;
+	decoder.sharedBandLo = (chunk->startRow - chunk->numRows) / 32;
+	decodeRle(&decoder, chunk->start, chunk->end);
+	if (!decoder.isValid)
+		atomicFetchAdd(&rle->numInvalid, 1);
+	atomicFetchAdd(&loadStepsDone, 1);
+}
+
+/* cuts the RLE body in [start, end) into chunks and works out the row every one of them starts on */
+ParallelRle *scanRleParallel(const char *start, const char *end, PackedCells *cells) {
+	ParallelRle *rle = (ParallelRle *)malloc(sizeof(ParallelRle));
+	if (!rle)
+		return NULL;
+
+	size_t chunkSize = (size_t)(end - start) / MAX_RLE_CHUNKS + 1;
+	if (chunkSize < RLE_CHUNK_SIZE)
+		chunkSize = RLE_CHUNK_SIZE;
+
+	rle->cells = cells;
+	rle->numChunks = 0;
+	rle->numInvalid = 0;
+	const char *p = start;
+	while (p < end) {
+		RleChunk *chunk = &rle->chunks[rle->numChunks++];
+		chunk->start = p;
+		chunk->hasEnd = GL_FALSE;
+		if ((size_t)(end - p) <= chunkSize || rle->numChunks == MAX_RLE_CHUNKS) {
+			p = end;
+		} else {
+			p += chunkSize;
+			while (p < end && *p != '$')
+				++p;
+			if (p < end)
+				++p;
+		}
+		chunk->end = p;
+	}
+
+	loadStepsDone = 0;
+	loadSteps = 2 * rle->numChunks;
+	parallelFor(rle->numChunks, countRleChunkRows, rle);
+	loadStepsDone = rle->numChunks;
+
+	int row = cells->height - 1;
+	for (int i = 0; i < rle->numChunks; ++i) {
+		rle->chunks[i].startRow = row;
+		row = rle->chunks[i].numRows <= row ? row - rle->chunks[i].numRows : -1;
+		if (rle->chunks[i].hasEnd) {
+			rle->numChunks = i + 1;
+			break;
+		}
+	}
+	return rle;
+}
+
+/* decodes the RLE body in [start, end) into cells, on all cores */
+GLboolean decodeRleParallel(RleDecoder *decoder, const char *start, const char *end) {
+	ParallelRle *rle = scanRleParallel(start, end, decoder->cells);
+	if (!rle)
+		return GL_FALSE;
+	parallelFor(rle->numChunks, decodeRleChunk, rle);
+	decoder->isValid = rle->numInvalid == 0;
+	free(rle);
+	return GL_TRUE;
+}
+
+/* live cell coordinates from a life 1.06 file, along with their bounding box */
+typedef struct CellCoordinates {
+	int32_t *xy;
+	size_t count;
+	size_t capacity;
+	int minX;
+	int maxX;
+	int minY;
+	int maxY;
+} CellCoordinates;
+
+/* parses a decimal integer of up to 8 digits all at once inside of a 64-bit register, p must
+   point at a digit and there must be at least 8 readable bytes. returns the number of digits */
+int parseDigitsSwar(const char *p, uint32_t *value) {
+	uint64_t chunk;
+	memcpy(&chunk, p, sizeof(chunk));
+	/* the top bit of every byte that is below '0' or above '9' ends up set, little endian so
+	   the lowest set byte is the first non-digit. borrows and carries only ever move upwards
+	   into bytes that come after the first non-digit, so they can't confuse the count */
+	uint64_t nonDigits = ((chunk - 0x3030303030303030ull) | (chunk + 0x4646464646464646ull)) & 0x8080808080808080ull;
+	int numDigits = nonDigits ? countTrailingZeros64(nonDigits) / 8 : 8;
+	if (numDigits == 0)
+		return 0;
+
+	/* shift the digits up so the ones we don't have turn into leading zeros, then combine
+	   neighboring digits into pairs, pairs into quads, and the quads into the final number */
+	uint64_t digits = (chunk - 0x3030303030303030ull) << (8 * (8 - numDigits));
+	digits = (digits * 10) + (digits >> 8);
+	digits = (((digits & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+		(((digits >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+	*value = (uint32_t)digits;
+	return numDigits;
+}
+
+/* skips whitespace and comment lines, returns end once there is nothing else left */
+const char *skipLifeComments(const char *p, const char *end) {
+	for (;;) {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+			++p;
+		if (p == end || *p != '#')
+			return p;
+		while (p < end && *p != '\n')
+			++p;
+	}
+}
+
+/* parses the integer at p, returns NULL if there isn't one there or it doesn't fit */
+const char *parseInteger(const char *p, const char *end, int *value) {
+	int sign = 1;
+	if (*p == '-' || *p == '+') {
+		sign = *p == '-' ? -1 : 1;
+		++p;
+	}
+	if (p == end || *p < '0' || *p > '9')
+		return NULL;
+
+	int64_t result = 0;
+	for (;;) {
+		int numDigits;
+		uint32_t digits;
+		if (end - p >= 8) {
+			numDigits = parseDigitsSwar(p, &digits);
+			if (numDigits == 0)
+				break;
+		} else {
+			if (p == end || *p < '0' || *p > '9')
+				break;
+			numDigits = 1;
+			digits = (uint32_t)(*p - '0');
+		}
+		for (int i = 0; i < numDigits; ++i)
+			result *= 10;
+		result += digits;
+		p += numDigits;
+		if (result > INT32_MAX)
+			return NULL;
+		if (numDigits < 8 && end - p >= 8)
+			break;
+	}
+	*value = sign * (int)result;
+	return p;
+}
+
+/* reads all "x y" coordinate pairs in a single pass, and keeps track of the bounding box
+   as we go. like before, the bounding box always includes the origin. anything other than
+   pairs of integers and comments makes the whole file invalid */
+GLboolean parseLifeCoordinates(const char *p, const char *end, CellCoordinates *coordinates) {
+	coordinates->xy = NULL;
+	coordinates->count = 0;
+	coordinates->capacity = 0;
+	coordinates->minX = 0;
+	coordinates->maxX = 0;
+	coordinates->minY = 0;
+	coordinates->maxY = 0;
+
+	int x, y;
+	while ((p = skipLifeComments(p, end)) != end) {
+		p = parseInteger(p, end, &x);
+		if (p)
+			p = parseInteger(skipLifeComments(p, end), end, &y);
+		if (!p) {
+			printf("invalid life file\n");
+			free(coordinates->xy);
+			coordinates->xy = NULL;
+			return GL_FALSE;
+		}
+		if (coordinates->count == coordinates->capacity) {
+			size_t capacity = coordinates->capacity ? 2 * coordinates->capacity : 4096;
+			int32_t *xy = (int32_t *)realloc(coordinates->xy, 2 * capacity * sizeof(int32_t));
+			if (!xy) {
+				printf("out of memory\n");
+				free(coordinates->xy);
+				coordinates->xy = NULL;
+				return GL_FALSE;
+			}
+			coordinates->xy = xy;
+			coordinates->capacity = capacity;
+		}
+		coordinates->xy[2 * coordinates->count + 0] = x;
+		coordinates->xy[2 * coordinates->count + 1] = y;
+		coordinates->count++;
+		if (x < coordinates->minX) coordinates->minX = x;
+		if (x > coordinates->maxX) coordinates->maxX = x;
+		if (y < coordinates->minY) coordinates->minY = y;
+		if (y > coordinates->maxY) coordinates->maxY = y;
+	}
+	return GL_TRUE;
+}
+
+#define SCATTER_BLOCK_SIZE (1 << 18)
+
+typedef struct ParallelScatter {
+	const CellCoordinates *coordinates;
+	PackedCells *cells;
+} ParallelScatter;
+
+void scatterCellBlock(void *arg, int index) {
+	ParallelScatter *scatter = (ParallelScatter *)arg;
+	const CellCoordinates *coordinates = scatter->coordinates;
+	PackedCells *cells = scatter->cells;
+	size_t start = (size_t)index * SCATTER_BLOCK_SIZE;
+	size_t end = start + SCATTER_BLOCK_SIZE < coordinates->count ? start + SCATTER_BLOCK_SIZE : coordinates->count;
+	for (size_t i = start; i < end; ++i) {
+		int x = coordinates->xy[2 * i + 0] - coordinates->minX;
+		int y = cells->height - 1 - (coordinates->xy[2 * i + 1] - coordinates->minY);
+		atomicOr(&cells->columns[(size_t)(y / 32) * (size_t)cells->columnsX + (size_t)x], 1u << (y % 32));
+	}
+	atomicFetchAdd(&loadStepsDone, 1);
+}
+
+/* sets all of the coordinates in cells, which must be exactly the size of the bounding box */
+void scatterCellCoordinates(const CellCoordinates *coordinates, PackedCells *cells) {
+	ParallelScatter scatter;
+	scatter.coordinates = coordinates;
+	scatter.cells = cells;
+	int numBlocks = (int)((coordinates->count + SCATTER_BLOCK_SIZE - 1) / SCATTER_BLOCK_SIZE);
+	loadStepsDone = 0;
+	loadSteps = numBlocks;
+	parallelFor(numBlocks, scatterCellBlock, &scatter);
+}
+
+/* skips the comment and header lines of a RLE file */
+const char *findRleBody(const char *p, const char *end) {
+	GLboolean isHeader = GL_FALSE;
+	while (p < end && !isHeader) {
+		isHeader = *p != '#';
+		while (p < end && *p != '\n')
+			++p;
+		if (p < end)
+			++p;
+	}
+	return p;
+}
+
+/* golly's macrocell format stores a pattern as a hash-consed quadtree. every line is a node,
+   numbered from 1 in the order they appear, 0 being the empty node. leaves are 8x8 bitmaps
+   written as rows of '.' and '*' separated by '$', and every other node is a line like
+   "level nw ne sw se". nodes only ever refer back to earlier nodes, and the last one is the
+   root. the quadtree has y pointing down while our rows go up, so everything is flipped */
+#define MAX_MACROCELL_LEVEL 60
+
+typedef struct MacrocellNode {
+	int level;
+	uint32_t children[4];
+	/* 8x8 bitmap for nodes of level 3 and below, row i is in byte i, column j in bit j */
+	uint64_t bits;
+	/* bounding box of all live cells relative to the top-left corner of the node */
+	int64_t minX, minY, maxX, maxY;
+} MacrocellNode;
+
+typedef struct Macrocell {
+	MacrocellNode *nodes;
+	uint32_t count;
+	uint32_t capacity;
+} Macrocell;
+
+GLboolean appendMacrocellNode(Macrocell *macrocell, const MacrocellNode *node) {
+	if (macrocell->count == macrocell->capacity) {
+		uint32_t capacity = macrocell->capacity ? 2 * macrocell->capacity : 4096;
+		MacrocellNode *nodes = (MacrocellNode *)realloc(macrocell->nodes, capacity * sizeof(MacrocellNode));
+		if (!nodes)
+			return GL_FALSE;
+		macrocell->nodes = nodes;
+		macrocell->capacity = capacity;
+	}
+	macrocell->nodes[macrocell->count++] = *node;
+	return GL_TRUE;
+}
+
+void findMacrocellBounds(const Macrocell *macrocell, MacrocellNode *node) {
+	node->minX = node->minY = INT64_MAX;
+	node->maxX = node->maxY = INT64_MIN;
+	if (node->level <= 3) {
+		for (int i = 0; i < 8; ++i) {
+			for (int j = 0; j < 8; ++j) {
+				if (node->bits & (1ull << (8 * i + j))) {
+					if (j < node->minX) node->minX = j;
+					if (j > node->maxX) node->maxX = j;
+					if (i < node->minY) node->minY = i;
+					if (i > node->maxY) node->maxY = i;
+				}
+			}
+		}
 		return;
+	}
 
-	if (pressedButton == GLFW_MOUSE_BUTTON_MIDDLE || keyModsArePressed()) {
-		offsetX -= scale * scaleX * (float)(deltaX / windowWidth);
-		offsetY -= scale * scaleY * (float)(deltaY / windowHeight);
+	int64_t half = (int64_t)1 << (node->level - 1);
+	for (int i = 0; i < 4; ++i) {
+		if (node->children[i] == 0)
+			continue;
+		const MacrocellNode *child = &macrocell->nodes[node->children[i]];
+		if (child->minX > child->maxX)
+			continue;
+		int64_t x = (i & 1) ? half : 0;
+		int64_t y = (i & 2) ? half : 0;
+		if (x + child->minX < node->minX) node->minX = x + child->minX;
+		if (x + child->maxX > node->maxX) node->maxX = x + child->maxX;
+		if (y + child->minY < node->minY) node->minY = y + child->minY;
+		if (y + child->maxY > node->maxY) node->maxY = y + child->maxY;
+	}
+}
+
+GLboolean parseMacrocell(Stream *stream, Macrocell *macrocell, int *generation) {
+	macrocell->nodes = NULL;
+	macrocell->count = 0;
+	macrocell->capacity = 0;
+	*generation = 0;
+
+	/* node 0 is the empty node */
+	MacrocellNode node;
+	memset(&node, 0, sizeof(node));
+	node.minX = node.minY = INT64_MAX;
+	node.maxX = node.maxY = INT64_MIN;
+	if (!appendMacrocellNode(macrocell, &node))
+		return GL_FALSE;
+
+	char line[1024];
+	while (readStreamLine(stream, line, sizeof(line))) {
+		char c = line[0];
+		memset(&node, 0, sizeof(node));
+		if (c == '#') {
+			if (line[1] == 'R' && strncmp(line + 2, " B3/S23", 7) != 0 && strncmp(line + 2, " b3/s23", 7) != 0)
+				printf("rule%.*s is not supported, using B3/S23 .. ", (int)strcspn(line + 2, "\r\n"), line + 2);
+			else if (line[1] == 'G')
+				*generation = atoi(line + 2);
+			continue;
+		} else if (c == '.' || c == '*' || c == '$') {
+			node.level = 3;
+			int x = 0, y = 0;
+			for (const char *p = line; *p && y < 8; ++p) {
+				if (*p == '$') {
+					++y;
+					x = 0;
+				} else if (*p == '.') {
+					++x;
+				} else if (*p == '*') {
+					if (x < 8)
+						node.bits |= 1ull << (8 * y + x);
+					++x;
+				}
+			}
+		} else if (c >= '0' && c <= '9') {
+			unsigned long children[4];
+			if (5 != sscanf(line, "%d %lu %lu %lu %lu", &node.level, &children[0], &children[1], &children[2], &children[3]))
+				return GL_FALSE;
+			if (node.level < 1 || node.level > MAX_MACROCELL_LEVEL)
+				return GL_FALSE;
+			for (int i = 0; i < 4 && node.level > 1; ++i) {
+				if (children[i] >= macrocell->count)
+					return GL_FALSE;
+				if (children[i] && macrocell->nodes[children[i]].level != node.level - 1)
+					return GL_FALSE;
+				node.children[i] = (uint32_t)children[i];
+			}
+			/* multi-state patterns have level 1 leaves holding 4 cell states, any state other
+			   than 0 is alive. small nodes are combined into bitmaps right away */
+			if (node.level == 1) {
+				node.bits = (children[0] ? 0x001 : 0) | (children[1] ? 0x002 : 0) | (children[2] ? 0x100 : 0) | (children[3] ? 0x200 : 0);
+			} else if (node.level <= 3) {
+				int half = 1 << (node.level - 1);
+				const MacrocellNode *nodes = macrocell->nodes;
+				node.bits = nodes[node.children[0]].bits |
+					(nodes[node.children[1]].bits << half) |
+					(nodes[node.children[2]].bits << (8 * half)) |
+					(nodes[node.children[3]].bits << (8 * half + half));
+			}
+		} else {
+			/* the [M2] header, and blank lines */
+			continue;
+		}
+
+		findMacrocellBounds(macrocell, &node);
+		if (!appendMacrocellNode(macrocell, &node))
+			return GL_FALSE;
+	}
+	return macrocell->count > 1;
+}
+
+typedef struct MacrocellTask {
+	uint32_t node;
+	int64_t x;
+	int64_t y;
+} MacrocellTask;
+
+typedef struct MacrocellExpansion {
+	const Macrocell *macrocell;
+	PackedCells *cells;
+	int64_t originX;
+	int64_t originY;
+	MacrocellTask *tasks;
+	int numTasks;
+	int capacity;
+} MacrocellExpansion;
+
+/* x and y are the top-left corner of the node in macrocell coordinates */
+void expandMacrocellNode(MacrocellExpansion *expansion, uint32_t index, int64_t x, int64_t y) {
+	if (index == 0)
+		return;
+
+	const MacrocellNode *node = &expansion->macrocell->nodes[index];
+	if (node->level > 3) {
+		int64_t half = (int64_t)1 << (node->level - 1);
+		expandMacrocellNode(expansion, node->children[0], x, y);
+		expandMacrocellNode(expansion, node->children[1], x + half, y);
+		expandMacrocellNode(expansion, node->children[2], x, y + half);
+		expandMacrocellNode(expansion, node->children[3], x + half, y + half);
 		return;
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, cellsReadFramebuffer);
-	glBindTexture(GL_TEXTURE_2D, cellsRead);
+	PackedCells *cells = expansion->cells;
+	int column = (int)(x - expansion->originX);
+	for (int i = 0; i < 8; ++i) {
+		unsigned rowBits = (unsigned)(node->bits >> (8 * i)) & 0xFF;
+		if (!rowBits)
+			continue;
+		int row = cells->height - 1 - (int)(y + i - expansion->originY);
+		uint32_t bit = 1u << (row % 32);
+		uint32_t *columns = &cells->columns[(size_t)(row / 32) * (size_t)cells->columnsX + (size_t)column];
+		for (int j = 0; j < 8; ++j)
+			if (rowBits & (1u << j))
+				columns[j] |= bit;
+	}
+}
 
-	uint8_t value = 0;
-	if (pressedButton == GLFW_MOUSE_BUTTON_LEFT)
-		value = 0xFF;
+GLboolean collectMacrocellTasks(MacrocellExpansion *expansion, uint32_t index, int64_t x, int64_t y, int taskLevel) {
+	if (index == 0)
+		return GL_TRUE;
 
-	/* Bresenham's line algorithm */
-	float mX0 = (float)(oldX / windowWidth);
-	float mY0 = (float)(oldY / windowHeight);
-	float mX1 = (float)(newX / windowWidth);
-	float mY1 = (float)(newY / windowHeight);
-	int x = (int)(numCellsX * (offsetX + mX0 * scaleX * scale));
-	int y = (int)(numCellsY * (offsetY + mY0 * scaleY * scale));
-	int xend = (int)(numCellsX * (offsetX + mX1 * scaleX * scale));
-	int yend = (int)(numCellsY * (offsetY + mY1 * scaleY * scale));
+	const MacrocellNode *node = &expansion->macrocell->nodes[index];
+	if (node->level > taskLevel) {
+		int64_t half = (int64_t)1 << (node->level - 1);
+		return
+			collectMacrocellTasks(expansion, node->children[0], x, y, taskLevel) &&
+			collectMacrocellTasks(expansion, node->children[1], x + half, y, taskLevel) &&
+			collectMacrocellTasks(expansion, node->children[2], x, y + half, taskLevel) &&
+			collectMacrocellTasks(expansion, node->children[3], x + half, y + half, taskLevel);
+	}
+
+	if (expansion->numTasks == expansion->capacity) {
+		int capacity = expansion->capacity ? 2 * expansion->capacity : 256;
+		MacrocellTask *tasks = (MacrocellTask *)realloc(expansion->tasks, (size_t)capacity * sizeof(MacrocellTask));
+		if (!tasks)
+			return GL_FALSE;
+		expansion->tasks = tasks;
+		expansion->capacity = capacity;
+	}
+	MacrocellTask *task = &expansion->tasks[expansion->numTasks++];
+	task->node = index;
+	task->x = x;
+	task->y = y;
+	return GL_TRUE;
+}
+
+void expandMacrocellTask(void *arg, int index) {
+	MacrocellExpansion *expansion = (MacrocellExpansion *)arg;
+	const MacrocellTask *task = &expansion->tasks[index];
+	expandMacrocellNode(expansion, task->node, task->x, task->y);
+	atomicFetchAdd(&loadStepsDone, 1);
+}
+
+/* expands the macrocell into packed cells that are cropped to the bounding box of the live cells.
+   the top of the crop is aligned to 32 rows so that any node of level 5 or more covers whole cell
+   columns, which lets separate subtrees be expanded on separate threads without any atomics */
+GLboolean expandMacrocell(const Macrocell *macrocell, PackedCells *cells) {
+	const MacrocellNode *root = &macrocell->nodes[macrocell->count - 1];
+	if (root->minX > root->maxX)
+		return allocPackedCells(cells, 1, 1);
+
+	int64_t originY = root->minY & ~(int64_t)31;
+	int64_t width = 1 + root->maxX - root->minX;
+	int64_t height = 1 + root->maxY - originY;
+	if (width > maxTextureSize || height > maxTextureSize) {
+		printf("%lld x %lld texture is larger than the maximum %d x %d .. ",
+			(long long)width, (long long)height, maxTextureSize, maxTextureSize);
+		return GL_FALSE;
+	}
+	if (!allocPackedCells(cells, (int)width, ceilMultipleOf32((int)height)))
+		return GL_FALSE;
+
+	MacrocellExpansion expansion;
+	expansion.macrocell = macrocell;
+	expansion.cells = cells;
+	expansion.originX = root->minX;
+	expansion.originY = originY;
+	expansion.tasks = NULL;
+	expansion.numTasks = 0;
+	expansion.capacity = 0;
+
+	/* a few thousand subtrees at most, but never smaller than a whole cell column */
+	int taskLevel = root->level - 6 > 5 ? root->level - 6 : 5;
+	if (!collectMacrocellTasks(&expansion, macrocell->count - 1, 0, 0, taskLevel)) {
+		free(expansion.tasks);
+		freePackedCells(cells);
+		return GL_FALSE;
+	}
+	loadStepsDone = 0;
+	loadSteps = expansion.numTasks;
+	parallelFor(expansion.numTasks, expandMacrocellTask, &expansion);
+	free(expansion.tasks);
+	return GL_TRUE;
+}
+
+/* builds the quadtree for the current world bottom up, giving identical subtrees the same node */
+typedef struct MacrocellWriter {
+	const PackedCells *cells;
+	Macrocell macrocell;
+	uint32_t *table;
+	size_t tableSize;
+	FILE *f;
+	GLboolean isOk;
+} MacrocellWriter;
+
+uint64_t hashMacrocellNode(const MacrocellNode *node) {
+	uint64_t hash = node->bits ^ ((uint64_t)node->level << 56);
+	for (int i = 0; i < 4; ++i)
+		hash = (hash ^ node->children[i]) * 0x100000001B3ull;
+	return hash ^ (hash >> 29);
+}
+
+GLboolean macrocellNodesAreEqual(const MacrocellNode *a, const MacrocellNode *b) {
+	return a->level == b->level && a->bits == b->bits &&
+		a->children[0] == b->children[0] && a->children[1] == b->children[1] &&
+		a->children[2] == b->children[2] && a->children[3] == b->children[3];
+}
+
+uint32_t findOrWriteMacrocellNode(MacrocellWriter *writer, const MacrocellNode *node) {
+	Macrocell *macrocell = &writer->macrocell;
+	if (2 * (size_t)macrocell->count >= writer->tableSize) {
+		size_t tableSize = writer->tableSize ? 2 * writer->tableSize : 1 << 16;
+		uint32_t *table = (uint32_t *)calloc(tableSize, sizeof(uint32_t));
+		if (!table) {
+			writer->isOk = GL_FALSE;
+			return 0;
+		}
+		for (uint32_t i = 1; i < macrocell->count; ++i) {
+			size_t slot = hashMacrocellNode(&macrocell->nodes[i]) & (tableSize - 1);
+			while (table[slot])
+				slot = (slot + 1) & (tableSize - 1);
+			table[slot] = i;
+		}
+		free(writer->table);
+		writer->table = table;
+		writer->tableSize = tableSize;
+	}
+
+	size_t slot = hashMacrocellNode(node) & (writer->tableSize - 1);
+	while (writer->table[slot]) {
+		if (macrocellNodesAreEqual(&macrocell->nodes[writer->table[slot]], node))
+			return writer->table[slot];
+		slot = (slot + 1) & (writer->tableSize - 1);
+	}
+
+	if (!appendMacrocellNode(macrocell, node)) {
+		writer->isOk = GL_FALSE;
+		return 0;
+	}
+	writer->table[slot] = macrocell->count - 1;
+
+	if (node->level == 3) {
+		char line[80];
+		int length = 0;
+		int numRows = 8;
+		while (numRows > 0 && ((node->bits >> (8 * (numRows - 1))) & 0xFF) == 0)
+			--numRows;
+		for (int i = 0; i < numRows; ++i) {
+			unsigned rowBits = (unsigned)(node->bits >> (8 * i)) & 0xFF;
+			for (int j = 0; rowBits >> j; ++j)
+				line[length++] = (rowBits & (1u << j)) ? '*' : '.';
+			line[length++] = '$';
+		}
+		line[length++] = '\n';
+		fwrite(line, 1, (size_t)length, writer->f);
+	} else {
+		fprintf(writer->f, "%d %u %u %u %u\n", node->level,
+			node->children[0], node->children[1], node->children[2], node->children[3]);
+	}
+	return macrocell->count - 1;
+}
+
+/* x and y are the top-left corner of the node in macrocell coordinates */
+uint32_t writeMacrocellNode(MacrocellWriter *writer, int level, int x, int y) {
+	const PackedCells *cells = writer->cells;
+	if (x >= cells->width || y >= cells->height || !writer->isOk)
+		return 0;
+
+	MacrocellNode node;
+	memset(&node, 0, sizeof(node));
+	node.level = level;
+	if (level == 3) {
+		/* the 8 rows of the leaf are always inside of a single cell column */
+		int row = cells->height - 1 - y;
+		const uint32_t *columns = &cells->columns[(size_t)(row / 32) * (size_t)cells->columnsX];
+		for (int j = 0; j < 8 && x + j < cells->width; ++j) {
+			unsigned columnBits = (columns[x + j] >> (row % 32 - 7)) & 0xFF;
+			for (int i = 0; i < 8; ++i)
+				if (columnBits & (0x80u >> i))
+					node.bits |= 1ull << (8 * i + j);
+		}
+		if (!node.bits)
+			return 0;
+	} else {
+		int half = 1 << (level - 1);
+		node.children[0] = writeMacrocellNode(writer, level - 1, x, y);
+		node.children[1] = writeMacrocellNode(writer, level - 1, x + half, y);
+		node.children[2] = writeMacrocellNode(writer, level - 1, x, y + half);
+		node.children[3] = writeMacrocellNode(writer, level - 1, x + half, y + half);
+		if (!node.children[0] && !node.children[1] && !node.children[2] && !node.children[3])
+			return 0;
+	}
+	return findOrWriteMacrocellNode(writer, &node);
+}
+
+/* writes the whole world to f as a macrocell file, returns false if something went wrong */
+GLboolean writeMacrocell(FILE *f, const PackedCells *cells, int atGeneration) {
+	MacrocellWriter writer;
+	memset(&writer, 0, sizeof(writer));
+	fprintf(f, "[M2] (GPU Life)\n#R B3/S23\n#G %d\n", atGeneration);
+	writer.f = f;
+	writer.cells = cells;
+	writer.isOk = GL_TRUE;
+	MacrocellNode empty;
+	memset(&empty, 0, sizeof(empty));
+	appendMacrocellNode(&writer.macrocell, &empty);
+
+	int level = 3;
+	while ((1 << level) < cells->width || (1 << level) < cells->height)
+		++level;
+	if (!writeMacrocellNode(&writer, level, 0, 0) && writer.isOk)
+		fprintf(f, "$\n");
+
+	free(writer.table);
+	free(writer.macrocell.nodes);
+	return writer.isOk && !ferror(f);
+}
+
+/* RLE export works on bands of cell column rows so that it can run on all cores. each band is
+   transposed into rows of cells 32x32 bits at a time, and the runs in each row are then found by
+   counting trailing zeros. bands only keep track of the empty rows at their edges, so stitching
+   them back together just means merging those counts */
+#define RLE_BAND_COLUMNS 4
+#define RLE_LINE_LENGTH 70
+
+typedef struct RleBand {
+	char *text;
+	size_t size;
+	size_t capacity;
+	int lineLength;
+	int leadingRows;
+	int trailingRows;
+	int minX, maxX, minY, maxY;
+	GLboolean hasCells;
+	GLboolean isOk;
+} RleBand;
+
+typedef struct RleEncoder {
+	const uint32_t *columns;
+	int width;
+	int numColumnsY;
+	int minX, maxX, minY, maxY;
+	RleBand *bands;
+	int numBands;
+} RleEncoder;
+
+/* bands go from the top of the world down, which is the order RLE rows are in */
+void getRleBandColumns(const RleEncoder *encoder, int band, int *top, int *bottom) {
+	*top = encoder->numColumnsY - 1 - band * RLE_BAND_COLUMNS;
+	*bottom = *top - RLE_BAND_COLUMNS + 1;
+	if (*bottom < 0)
+		*bottom = 0;
+}
+
+void findRleBandBounds(void *arg, int band) {
+	RleEncoder *encoder = (RleEncoder *)arg;
+	RleBand *out = &encoder->bands[band];
+	int top, bottom;
+	getRleBandColumns(encoder, band, &top, &bottom);
+	out->minX = out->minY = INT32_MAX;
+	out->maxX = out->maxY = -1;
+	for (int cy = bottom; cy <= top; ++cy) {
+		const uint32_t *words = &encoder->columns[(size_t)cy * (size_t)encoder->width];
+		int first = 0;
+		while (first < encoder->width && !words[first])
+			++first;
+		if (first == encoder->width)
+			continue;
+		int last = encoder->width - 1;
+		while (!words[last])
+			--last;
+		uint32_t any = 0;
+		for (int x = first; x <= last; ++x)
+			any |= words[x];
+
+		int lowBit = countTrailingZeros64(any);
+		int highBit = 31;
+		while (!(any >> highBit))
+			--highBit;
+		if (first < out->minX) out->minX = first;
+		if (last > out->maxX) out->maxX = last;
+		if (cy * 32 + lowBit < out->minY) out->minY = cy * 32 + lowBit;
+		if (cy * 32 + highBit > out->maxY) out->maxY = cy * 32 + highBit;
+	}
+}
+
+void appendRleToken(RleBand *band, int count, char tag) {
+	char token[16];
+	int length = count > 1 ? snprintf(token, sizeof(token), "%d%c", count, tag) : snprintf(token, sizeof(token), "%c", tag);
+	/* leave a spot at the end of each line for the terminating ! */
+	if (band->lineLength + length >= RLE_LINE_LENGTH) {
+		token[length] = '\0';
+		memmove(token + 1, token, (size_t)length + 1);
+		token[0] = '\n';
+		++length;
+		band->lineLength = -1;
+	}
+	if (band->size + (size_t)length > band->capacity) {
+		size_t capacity = band->capacity ? 2 * band->capacity : 4096;
+		char *text = (char *)realloc(band->text, capacity);
+		if (!text) {
+			band->isOk = GL_FALSE;
+			return;
+		}
+		band->text = text;
+		band->capacity = capacity;
+	}
+	memcpy(band->text + band->size, token, (size_t)length);
+	band->size += (size_t)length;
+	band->lineLength += length;
+}
+
+/* position of the first bit at or after x that is set (or clear), row starts at cell firstX */
+int findRowBit(const uint32_t *row, int numWords, int firstX, int x, GLboolean isSet) {
+	int i = (x - firstX) / 32;
+	if (i >= numWords)
+		return firstX + 32 * numWords;
+	uint32_t word = (isSet ? row[i] : ~row[i]) & (0xFFFFFFFFu << ((x - firstX) & 31));
+	while (!word) {
+		if (++i == numWords)
+			return firstX + 32 * numWords;
+		word = isSet ? row[i] : ~row[i];
+	}
+	return firstX + 32 * i + countTrailingZeros64(word);
+}
+
+void encodeRleRow(RleEncoder *encoder, RleBand *band, const uint32_t *row, int numWords, int firstX, int *emptyRows) {
+	int x = encoder->minX;
+	int end = encoder->maxX + 1;
+	for (;;) {
+		int start = findRowBit(row, numWords, firstX, x, GL_TRUE);
+		if (start >= end)
+			break;
+		int stop = findRowBit(row, numWords, firstX, start, GL_FALSE);
+		if (stop > end)
+			stop = end;
+
+		if (x == encoder->minX) {
+			if (!band->hasCells)
+				band->leadingRows = *emptyRows;
+			else
+				appendRleToken(band, *emptyRows + 1, '$');
+			band->hasCells = GL_TRUE;
+			*emptyRows = 0;
+		}
+		if (start > x)
+			appendRleToken(band, start - x, 'b');
+		appendRleToken(band, stop - start, 'o');
+		x = stop;
+	}
+	if (x == encoder->minX)
+		++*emptyRows;
+}
+
+void encodeRleBand(void *arg, int band) {
+	RleEncoder *encoder = (RleEncoder *)arg;
+	RleBand *out = &encoder->bands[band];
+	int top, bottom;
+	getRleBandColumns(encoder, band, &top, &bottom);
+	int firstWord = encoder->minX / 32;
+	int numWords = encoder->maxX / 32 - firstWord + 1;
+	uint32_t *rows = (uint32_t *)malloc(32 * (size_t)numWords * sizeof(uint32_t));
+	if (!rows) {
+		out->isOk = GL_FALSE;
+		return;
+	}
+
+	int emptyRows = 0;
+	for (int cy = top; cy >= bottom; --cy) {
+		if (cy * 32 > encoder->maxY || cy * 32 + 31 < encoder->minY) {
+			emptyRows += 32;
+			continue;
+		}
+		const uint32_t *words = &encoder->columns[(size_t)cy * (size_t)encoder->width + 32 * (size_t)firstWord];
+		for (int k = 0; k < numWords; ++k) {
+			uint32_t block[32];
+			memcpy(block, &words[32 * k], sizeof(block));
+			transpose32(block);
+			for (int i = 0; i < 32; ++i)
+				rows[i * numWords + k] = block[i];
+		}
+		for (int i = 31; i >= 0; --i)
+			encodeRleRow(encoder, out, &rows[i * numWords], numWords, 32 * firstWord, &emptyRows);
+	}
+	if (!out->hasCells)
+		out->leadingRows = emptyRows;
+	out->trailingRows = emptyRows;
+	free(rows);
+}
+
+/* writes the cropped pattern to f, returns false if something went wrong */
+GLboolean writeRle(FILE *f, const uint32_t *columns, int width, int height, int atGeneration) {
+	RleEncoder encoder;
+	encoder.columns = columns;
+	encoder.width = width;
+	encoder.numColumnsY = height / 32;
+	encoder.numBands = (encoder.numColumnsY + RLE_BAND_COLUMNS - 1) / RLE_BAND_COLUMNS;
+	encoder.bands = (RleBand *)calloc((size_t)encoder.numBands, sizeof(RleBand));
+	if (!encoder.bands)
+		return GL_FALSE;
+
+	parallelFor(encoder.numBands, findRleBandBounds, &encoder);
+	encoder.minX = encoder.minY = INT32_MAX;
+	encoder.maxX = encoder.maxY = -1;
+	for (int i = 0; i < encoder.numBands; ++i) {
+		RleBand *band = &encoder.bands[i];
+		if (band->minX < encoder.minX) encoder.minX = band->minX;
+		if (band->maxX > encoder.maxX) encoder.maxX = band->maxX;
+		if (band->minY < encoder.minY) encoder.minY = band->minY;
+		if (band->maxY > encoder.maxY) encoder.maxY = band->maxY;
+		band->isOk = GL_TRUE;
+	}
+
+	GLboolean isOk = GL_TRUE;
+	fprintf(f, "#C saved by GPU Life at generation %d\n", atGeneration);
+	if (encoder.maxX < 0) {
+		fprintf(f, "x = 0, y = 0, rule = B3/S23\n!\n");
+		free(encoder.bands);
+		return !ferror(f);
+	}
+	fprintf(f, "x = %d, y = %d, rule = B3/S23\n", encoder.maxX - encoder.minX + 1, encoder.maxY - encoder.minY + 1);
+	parallelFor(encoder.numBands, encodeRleBand, &encoder);
+
+	/* the empty rows between two bands become a single row skip on its own line */
+	GLboolean hasStarted = GL_FALSE;
+	int emptyRows = 0;
+	for (int i = 0; i < encoder.numBands; ++i) {
+		RleBand *band = &encoder.bands[i];
+		isOk &= band->isOk;
+		if (!band->hasCells) {
+			emptyRows += band->leadingRows;
+			continue;
+		}
+		if (hasStarted) {
+			int skip = emptyRows + band->leadingRows + 1;
+			if (skip > 1)
+				fprintf(f, "\n%d$\n", skip);
+			else
+				fprintf(f, "\n$\n");
+		}
+		if (isOk)
+			fwrite(band->text, 1, band->size, f);
+		hasStarted = GL_TRUE;
+		emptyRows = band->trailingRows;
+	}
+	fprintf(f, "!\n");
+
+	for (int i = 0; i < encoder.numBands; ++i)
+		free(encoder.bands[i].text);
+	free(encoder.bands);
+	return isOk && !ferror(f);
+}
+
+/* a small LZ77 codec in the style of LZ4, so that compressed snapshots don't need any external
+   library. a block is a sequence of [token][literals][offset][match] where the token holds 4 bits
+   of literal length and 4 bits of match length, both extended by 255-bytes when they overflow.
+   matches are at least 4 bytes long and at most 64k back. the last sequence has no match */
+#define LZ_HASH_BITS 16
+#define LZ_MIN_MATCH 4
+
+size_t lzCompressBound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+uint8_t *writeLzLength(uint8_t *dst, size_t length) {
+	for (; length >= 255; length -= 255)
+		*dst++ = 255;
+	*dst++ = (uint8_t)length;
+	return dst;
+}
+
+uint8_t *writeLzSequence(uint8_t *dst, const uint8_t *literals, size_t numLiterals, size_t offset, size_t matchLength) {
+	uint8_t *token = dst++;
+	*token = (uint8_t)((numLiterals < 15 ? numLiterals : 15) << 4);
+	if (numLiterals >= 15)
+		dst = writeLzLength(dst, numLiterals - 15);
+	memcpy(dst, literals, numLiterals);
+	dst += numLiterals;
+	if (matchLength == 0)
+		return dst;
+
+	size_t length = matchLength - LZ_MIN_MATCH;
+	*token |= (uint8_t)(length < 15 ? length : 15);
+	*dst++ = (uint8_t)(offset & 0xFF);
+	*dst++ = (uint8_t)(offset >> 8);
+	if (length >= 15)
+		dst = writeLzLength(dst, length - 15);
+	return dst;
+}
+
+/* dst must have room for lzCompressBound(size) bytes, returns the compressed size */
+size_t lzCompress(const uint8_t *src, size_t size, uint8_t *dst) {
+	uint32_t *table = (uint32_t *)calloc((size_t)1 << LZ_HASH_BITS, sizeof(uint32_t));
+	if (!table)
+		return writeLzSequence(dst, src, size, 0, 0) - dst;
+
+	uint8_t *out = dst;
+	size_t anchor = 0;
+	size_t ip = 0;
+	size_t limit = size > 12 ? size - 12 : 0;
+	while (ip < limit) {
+		uint32_t sequence;
+		memcpy(&sequence, src + ip, sizeof(sequence));
+		uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+		size_t ref = table[hash];
+		table[hash] = (uint32_t)ip + 1;
+
+		uint32_t refSequence = 0;
+		if (ref)
+			memcpy(&refSequence, src + ref - 1, sizeof(refSequence));
+		if (!ref || ip - (ref - 1) > 0xFFFF || refSequence != sequence) {
+			/* skip ahead faster the longer we go without finding a match */
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+		}
+
+		--ref;
+		size_t length = LZ_MIN_MATCH;
+		while (ip + length < size && src[ref + length] == src[ip + length])
+			++length;
+		out = writeLzSequence(out, src + anchor, ip - anchor, ip - ref, length);
+		ip += length;
+		anchor = ip;
+	}
+	out = writeLzSequence(out, src + anchor, size - anchor, 0, 0);
+	free(table);
+	return (size_t)(out - dst);
+}
+
+GLboolean readLzLength(const uint8_t **src, const uint8_t *end, size_t *length) {
+	uint8_t byte;
+	do {
+		if (*src == end)
+			return GL_FALSE;
+		byte = *(*src)++;
+		*length += byte;
+	} while (byte == 255);
+	return GL_TRUE;
+}
+
+/* decompresses exactly dstSize bytes, returns false for any malformed input */
+GLboolean lzDecompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize) {
+	const uint8_t *end = src + srcSize;
+	size_t op = 0;
+	while (src < end) {
+		uint8_t token = *src++;
+		size_t numLiterals = token >> 4;
+		if (numLiterals == 15 && !readLzLength(&src, end, &numLiterals))
+			return GL_FALSE;
+		if (numLiterals > (size_t)(end - src) || numLiterals > dstSize - op)
+			return GL_FALSE;
+		memcpy(dst + op, src, numLiterals);
+		src += numLiterals;
+		op += numLiterals;
+		if (src == end)
+			break;
+
+		if (end - src < 2)
+			return GL_FALSE;
+		size_t offset = (size_t)src[0] | ((size_t)src[1] << 8);
+		src += 2;
+		size_t length = token & 15;
+		if (length == 15 && !readLzLength(&src, end, &length))
+			return GL_FALSE;
+		length += LZ_MIN_MATCH;
+		if (offset == 0 || offset > op || length > dstSize - op)
+			return GL_FALSE;
+		/* matches may overlap themselves, so this has to go byte by byte */
+		for (size_t i = 0; i < length; ++i, ++op)
+			dst[op] = dst[op - offset];
+	}
+	return op == dstSize;
+}
+
+/* the first stage of snapshot compression, and the one that does the most work for mostly empty
+   worlds: the column words are written as [zero words][literal words][literals..] runs with both
+   counts as variable length integers */
+uint8_t *writeVarint(uint8_t *dst, uint32_t value) {
+	for (; value >= 0x80; value >>= 7)
+		*dst++ = (uint8_t)(value | 0x80);
+	*dst++ = (uint8_t)value;
+	return dst;
+}
+
+GLboolean readVarint(const uint8_t **src, const uint8_t *end, uint32_t *value) {
+	*value = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (*src == end)
+			return GL_FALSE;
+		uint8_t byte = *(*src)++;
+		*value |= (uint32_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return GL_TRUE;
+	}
+	return GL_FALSE;
+}
+
+/* same as decodeZeroRuns, but XORs the literals into words and leaves the zero runs alone */
+GLboolean applyZeroRuns(const uint8_t *src, size_t size, uint32_t *words, size_t numWords) {
+	const uint8_t *end = src + size;
+	size_t i = 0;
+	while (src < end) {
+		uint32_t numZeros, numLiterals;
+		if (!readVarint(&src, end, &numZeros) || !readVarint(&src, end, &numLiterals))
+			return GL_FALSE;
+		if (numZeros > numWords - i || numLiterals > numWords - i - numZeros)
+			return GL_FALSE;
+		if ((size_t)(end - src) < (size_t)numLiterals * sizeof(uint32_t))
+			return GL_FALSE;
+		i += numZeros;
+		for (uint32_t j = 0; j < numLiterals; ++j, ++i, src += sizeof(uint32_t)) {
+			uint32_t literal;
+			memcpy(&literal, src, sizeof(literal));
+			words[i] ^= literal;
+		}
+	}
+	return i == numWords;
+}
+
+size_t zeroRunBound(size_t numWords) {
+	return numWords * sizeof(uint32_t) + 10 * (numWords / 2 + 1);
+}
+
+size_t encodeZeroRuns(const uint32_t *words, size_t numWords, uint8_t *dst) {
+	uint8_t *out = dst;
+	size_t i = 0;
+	while (i < numWords) {
+		size_t numZeros = 0;
+		while (i + numZeros < numWords && words[i + numZeros] == 0 && numZeros < 0xFFFFFFFF)
+			++numZeros;
+		i += numZeros;
+		size_t numLiterals = 0;
+		while (i + numLiterals < numWords && words[i + numLiterals] != 0 && numLiterals < 0xFFFFFFFF)
+			++numLiterals;
+		out = writeVarint(out, (uint32_t)numZeros);
+		out = writeVarint(out, (uint32_t)numLiterals);
+		memcpy(out, &words[i], numLiterals * sizeof(uint32_t));
+		out += numLiterals * sizeof(uint32_t);
+		i += numLiterals;
+	}
+	return (size_t)(out - dst);
+}
+
+GLboolean decodeZeroRuns(const uint8_t *src, size_t size, uint32_t *words, size_t numWords) {
+	const uint8_t *end = src + size;
+	size_t i = 0;
+	while (src < end) {
+		uint32_t numZeros, numLiterals;
+		if (!readVarint(&src, end, &numZeros) || !readVarint(&src, end, &numLiterals))
+			return GL_FALSE;
+		if (numZeros > numWords - i || numLiterals > numWords - i - numZeros)
+			return GL_FALSE;
+		if ((size_t)(end - src) < (size_t)numLiterals * sizeof(uint32_t))
+			return GL_FALSE;
+		memset(&words[i], 0, (size_t)numZeros * sizeof(uint32_t));
+		i += numZeros;
+		memcpy(&words[i], src, (size_t)numLiterals * sizeof(uint32_t));
+		src += (size_t)numLiterals * sizeof(uint32_t);
+		i += numLiterals;
+	}
+	return i == numWords;
+}
+
+/* snapshots store the world exactly the way it sits in the cell texture, so that they can be
+   mapped into memory and uploaded straight from the mapping. a 64 byte header is followed by
+   the column words, row by row. everything is little endian.
+   compressed snapshots instead split the world into bands of cell columns which are compressed
+   independently, so they can be packed and unpacked on all cores. the header is followed by
+   the number of bands and how many rows of cell columns each one has, then a table with the
+   zero run size and LZ size of every band, and then all of the LZ blocks back to back */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_COMPRESSED 1
+#define SNAPSHOT_BAND_SIZE (1 << 20)
+
+/* parsed patterns are kept as snapshots named after the hash of the file they came from */
+#define CACHE_DIRECTORY ".gpulife-cache"
+#define CACHE_MIN_FILE_SIZE (64 << 10)
+
+typedef struct SnapshotHeader {
+	char magic[8];
+	uint32_t version;
+	int32_t width;
+	int32_t height;
+	uint32_t flags;
+	int64_t generation;
+	/* hash64 of all of the column words */
+	uint64_t checksum;
+	char rule[16];
+	uint8_t reserved[8];
+} SnapshotHeader;
+
+void initSnapshotHeader(SnapshotHeader *header) {
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, "GPULIFE", 8);
+	header->version = SNAPSHOT_VERSION;
+	header->width = numCellsX;
+	header->height = numCellsY;
+	header->generation = generation;
+	strcpy(header->rule, "B3/S23");
+}
+
+typedef struct SnapshotBand {
+	uint32_t zeroRunSize;
+	uint32_t compressedSize;
+} SnapshotBand;
+
+typedef struct SnapshotCodec {
+	uint32_t *columns;
+	int width;
+	int bandColumnsY;
+	int numColumnsY;
+	SnapshotBand *bands;
+	uint8_t **compressed;
+	const uint8_t **compressedBands;
+	volatile int isOk;
+} SnapshotCodec;
+
+size_t getSnapshotBandWords(const SnapshotCodec *codec, int band) {
+	int numColumnsY = codec->numColumnsY - band * codec->bandColumnsY;
+	if (numColumnsY > codec->bandColumnsY)
+		numColumnsY = codec->bandColumnsY;
+	return (size_t)numColumnsY * (size_t)codec->width;
+}
+
+void compressSnapshotBand(void *arg, int band) {
+	SnapshotCodec *codec = (SnapshotCodec *)arg;
+	size_t numWords = getSnapshotBandWords(codec, band);
+	const uint32_t *words = &codec->columns[(size_t)band * (size_t)codec->bandColumnsY * (size_t)codec->width];
+	uint8_t *zeroRuns = (uint8_t *)malloc(zeroRunBound(numWords));
+	size_t zeroRunSize = zeroRuns ? encodeZeroRuns(words, numWords, zeroRuns) : 0;
+	uint8_t *compressed = zeroRuns ? (uint8_t *)malloc(lzCompressBound(zeroRunSize)) : NULL;
+	if (!compressed) {
+		free(zeroRuns);
+		codec->isOk = 0;
+		return;
+	}
+	codec->bands[band].zeroRunSize = (uint32_t)zeroRunSize;
+	codec->bands[band].compressedSize = (uint32_t)lzCompress(zeroRuns, zeroRunSize, compressed);
+	codec->compressed[band] = compressed;
+	free(zeroRuns);
+}
+
+void decompressSnapshotBand(void *arg, int band) {
+	SnapshotCodec *codec = (SnapshotCodec *)arg;
+	size_t numWords = getSnapshotBandWords(codec, band);
+	uint32_t *words = &codec->columns[(size_t)band * (size_t)codec->bandColumnsY * (size_t)codec->width];
+	size_t zeroRunSize = codec->bands[band].zeroRunSize;
+	uint8_t *zeroRuns = (uint8_t *)malloc(zeroRunSize ? zeroRunSize : 1);
+	if (!zeroRuns ||
+		!lzDecompress(codec->compressedBands[band], codec->bands[band].compressedSize, zeroRuns, zeroRunSize) ||
+		!decodeZeroRuns(zeroRuns, zeroRunSize, words, numWords))
+		codec->isOk = 0;
+	free(zeroRuns);
+	atomicFetchAdd(&loadStepsDone, 1);
+}
+
+void initSnapshotCodec(SnapshotCodec *codec, uint32_t *columns, int width, int height, int bandColumnsY) {
+	codec->columns = columns;
+	codec->width = width;
+	codec->numColumnsY = height / 32;
+	codec->bandColumnsY = bandColumnsY;
+	codec->bands = NULL;
+	codec->compressed = NULL;
+	codec->compressedBands = NULL;
+	codec->isOk = 1;
+}
+
+int getNumSnapshotBands(const SnapshotCodec *codec) {
+	return (codec->numColumnsY + codec->bandColumnsY - 1) / codec->bandColumnsY;
+}
+
+/* the part after the header of a compressed snapshot */
+GLboolean loadCompressedSnapshot(const SnapshotHeader *header, const uint8_t *data, size_t size, PackedCells *cells) {
+	uint32_t numBands, bandColumnsY;
+	if (size < 8)
+		return GL_FALSE;
+	memcpy(&numBands, data, 4);
+	memcpy(&bandColumnsY, data + 4, 4);
+	data += 8;
+	size -= 8;
+	if (bandColumnsY < 1 || numBands != (uint32_t)((header->height / 32 + bandColumnsY - 1) / bandColumnsY))
+		return GL_FALSE;
+	if (size / sizeof(SnapshotBand) < numBands)
+		return GL_FALSE;
+
+	SnapshotCodec codec;
+	if (!allocPackedCells(cells, header->width, header->height))
+		return GL_FALSE;
+	initSnapshotCodec(&codec, cells->columns, header->width, header->height, (int)bandColumnsY);
+	codec.bands = (SnapshotBand *)malloc(numBands * sizeof(SnapshotBand));
+	codec.compressedBands = (const uint8_t **)malloc(numBands * sizeof(uint8_t *));
+	if (!codec.bands || !codec.compressedBands)
+		codec.isOk = 0;
+	if (codec.isOk) {
+		memcpy(codec.bands, data, numBands * sizeof(SnapshotBand));
+		data += numBands * sizeof(SnapshotBand);
+		size -= numBands * sizeof(SnapshotBand);
+		for (uint32_t i = 0; i < numBands && codec.isOk; ++i) {
+			codec.compressedBands[i] = data;
+			if (codec.bands[i].compressedSize > size)
+				codec.isOk = 0;
+			else {
+				data += codec.bands[i].compressedSize;
+				size -= codec.bands[i].compressedSize;
+			}
+		}
+	}
+	if (codec.isOk) {
+		loadStepsDone = 0;
+		loadSteps = (int)numBands;
+		parallelFor((int)numBands, decompressSnapshotBand, &codec);
+	}
+	free(codec.bands);
+	free((void *)codec.compressedBands);
+	if (!codec.isOk)
+		freePackedCells(cells);
+	return codec.isOk;
+}
+
+/* what a pattern file turns into off the main thread, ready to be swapped in with one upload */
+typedef enum LoadedKind {
+	LOADED_CELLS,
+	LOADED_RUNS,
+	LOADED_SNAPSHOT,
+	LOADED_RECORDING,
+} LoadedKind;
+
+typedef struct LoadedPattern {
+	LoadedKind kind;
+	PackedCells cells;
+	CellRuns runs;
+	int width;
+	int height;
+	MappedFile snapshot;
+	int generation;
+} LoadedPattern;
+
+/* checks a snapshot and gets it ready to upload. plain snapshots stay mapped so that they
+   can be uploaded straight out of the file, compressed ones are unpacked into cells */
+GLboolean readSnapshot(const char *file, LoadedPattern *loaded) {
+	MappedFile mapped;
+	if (!mapFile(&mapped, file)) {
+		printf("couldnt map file\n");
+		return GL_FALSE;
+	}
+
+	const SnapshotHeader *header = (const SnapshotHeader *)mapped.data;
+	const uint32_t *columns = (const uint32_t *)(mapped.data + sizeof(SnapshotHeader));
+	size_t size = 0;
+	GLboolean isOk = mapped.size >= sizeof(SnapshotHeader) && header->version == SNAPSHOT_VERSION &&
+		header->width > 0 && header->height > 0 && header->width % 32 == 0 && header->height % 32 == 0;
+	if (isOk) {
+		size = (size_t)header->width * (size_t)(header->height / 32) * sizeof(uint32_t);
+		isOk = (header->flags & SNAPSHOT_COMPRESSED) || mapped.size - sizeof(SnapshotHeader) >= size;
+	}
+	if (!isOk) {
+		printf("invalid snapshot file\n");
+		unmapFile(&mapped);
+		return GL_FALSE;
+	}
+
+	if (header->flags & SNAPSHOT_COMPRESSED) {
+		SnapshotHeader compressedHeader = *header;
+		isOk = loadCompressedSnapshot(header, (const uint8_t *)columns, mapped.size - sizeof(SnapshotHeader), &loaded->cells);
+		unmapFile(&mapped);
+		if (!isOk) {
+			printf("invalid snapshot file\n");
+			return GL_FALSE;
+		}
+		if (hash64(loaded->cells.columns, size, 0) != compressedHeader.checksum) {
+			printf("snapshot is corrupted\n");
+			freePackedCells(&loaded->cells);
+			return GL_FALSE;
+		}
+		loaded->kind = LOADED_CELLS;
+		loaded->generation = (int)compressedHeader.generation;
+		return GL_TRUE;
+	}
+
+	if (hash64(columns, size, 0) != header->checksum) {
+		printf("snapshot is corrupted\n");
+		unmapFile(&mapped);
+		return GL_FALSE;
+	}
+	loaded->kind = LOADED_SNAPSHOT;
+	loaded->snapshot = mapped;
+	loaded->generation = (int)header->generation;
+	return GL_TRUE;
+}
+
+void uploadSnapshot(const MappedFile *mapped) {
+	const SnapshotHeader *header = (const SnapshotHeader *)mapped->data;
+	if (!resizeCells(header->width, header->height))
+		return;
+	glBindTexture(GL_TEXTURE_2D, cellsRead);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)numCellsX, (GLsizei)(numCellsY / 32),
+		GL_RED_INTEGER, GL_UNSIGNED_INT, mapped->data + sizeof(SnapshotHeader));
+	glCheckErrors();
+	centerCellsOnScreen();
+}
+
+/* saving reads the cell texture back into a pixel buffer without waiting for it, once the GPU
+   is done the buffer is mapped and a thread writes it out straight from the mapping */
+typedef enum SnapshotSaveState {
+	SNAPSHOT_IDLE,
+	SNAPSHOT_READING,
+	SNAPSHOT_WRITING,
+} SnapshotSaveState;
+
+typedef struct SnapshotSave {
+	SnapshotSaveState state;
+	GLuint buffer;
+	GLsync fence;
+	int framesWaited;
+	SnapshotHeader header;
+	const uint32_t *columns;
+	char path[512];
+	void (*write)(void *arg);
+	Thread writer;
+	volatile int writerIsDone;
+	GLboolean isCompressed;
+	GLboolean isOk;
+} SnapshotSave;
+
+SnapshotSave snapshotSave;
+
+void writeSnapshot(void *arg) {
+	SnapshotSave *save = (SnapshotSave *)arg;
+	size_t size = (size_t)save->header.width * (size_t)(save->header.height / 32) * sizeof(uint32_t);
+	save->header.checksum = hash64(save->columns, size, 0);
+	save->isOk = GL_FALSE;
+
+	SnapshotCodec codec;
+	int numBands = 0;
+	if (save->isCompressed) {
+		save->header.flags |= SNAPSHOT_COMPRESSED;
+		int bandColumnsY = SNAPSHOT_BAND_SIZE / (save->header.width * (int)sizeof(uint32_t));
+		initSnapshotCodec(&codec, (uint32_t *)save->columns, save->header.width, save->header.height, bandColumnsY > 0 ? bandColumnsY : 1);
+		numBands = getNumSnapshotBands(&codec);
+		codec.bands = (SnapshotBand *)calloc((size_t)numBands, sizeof(SnapshotBand));
+		codec.compressed = (uint8_t **)calloc((size_t)numBands, sizeof(uint8_t *));
+		if (codec.bands && codec.compressed)
+			parallelFor(numBands, compressSnapshotBand, &codec);
+		else
+			codec.isOk = 0;
+	}
+
+	FILE *f = fopen(save->path, "wb");
+	if (f && (!save->isCompressed || codec.isOk)) {
+		save->isOk = fwrite(&save->header, sizeof(save->header), 1, f) == 1;
+		if (save->isCompressed) {
+			uint32_t bandInfo[2] = { (uint32_t)numBands, (uint32_t)codec.bandColumnsY };
+			save->isOk &= fwrite(bandInfo, sizeof(bandInfo), 1, f) == 1;
+			save->isOk &= fwrite(codec.bands, sizeof(SnapshotBand), (size_t)numBands, f) == (size_t)numBands;
+			for (int i = 0; i < numBands && save->isOk; ++i)
+				save->isOk = fwrite(codec.compressed[i], 1, codec.bands[i].compressedSize, f) == codec.bands[i].compressedSize;
+		} else {
+			save->isOk &= fwrite(save->columns, 1, size, f) == size;
+		}
+	}
+	if (f)
+		save->isOk &= fclose(f) == 0;
+
+	if (save->isCompressed) {
+		for (int i = 0; codec.compressed && i < numBands; ++i)
+			free(codec.compressed[i]);
+		free(codec.compressed);
+		free(codec.bands);
+	}
+	atomicFetchAdd(&save->writerIsDone, 1);
+}
+
+void writeRleFile(void *arg) {
+	SnapshotSave *save = (SnapshotSave *)arg;
+	save->isOk = GL_FALSE;
+	FILE *f = fopen(save->path, "wb");
+	if (f) {
+		save->isOk = writeRle(f, save->columns, save->header.width, save->header.height, (int)save->header.generation);
+		save->isOk &= fclose(f) == 0;
+	}
+	atomicFetchAdd(&save->writerIsDone, 1);
+}
+
+void writeMacrocellFile(void *arg) {
+	SnapshotSave *save = (SnapshotSave *)arg;
+	save->isOk = GL_FALSE;
+	FILE *f = fopen(save->path, "wb");
+	if (f) {
+		/* the writer only reads the cells, so they can stay in the mapping */
+		PackedCells cells;
+		cells.width = save->header.width;
+		cells.height = save->header.height;
+		cells.columnsX = save->header.width;
+		cells.columnsY = save->header.height / 32;
+		cells.columns = (uint32_t *)save->columns;
+		save->isOk = writeMacrocell(f, &cells, (int)save->header.generation);
+		save->isOk &= fclose(f) == 0;
+	}
+	atomicFetchAdd(&save->writerIsDone, 1);
+}
+
+/* starts reading back the world into a pixel buffer, once the GPU is done with it
+   pollSnapshotSave hands the mapped buffer over to the write function on a separate thread */
+GLboolean beginSave(const char *path, void (*write)(void *arg)) {
+	if (snapshotSave.state != SNAPSHOT_IDLE) {
+		printf("still saving %s\n", snapshotSave.path);
+		return GL_FALSE;
+	}
+
+	SnapshotSave *save = &snapshotSave;
+	save->write = write;
+	snprintf(save->path, sizeof(save->path), "%s", path);
+	printf("saving %s .. \n", save->path);
+	initSnapshotHeader(&save->header);
+
+	size_t size = (size_t)numCellsX * (size_t)(numCellsY / 32) * sizeof(uint32_t);
+	if (!save->buffer)
+		glGenBuffers(1, &save->buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, save->buffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_READ);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, cellsReadFramebuffer);
+	glReadPixels(0, 0, numCellsX, numCellsY / 32, GL_RED_INTEGER, GL_UNSIGNED_INT, (void *)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	save->fence = glFenceSync ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : NULL;
+	save->framesWaited = 0;
+	save->state = SNAPSHOT_READING;
+	glCheckErrors();
+	return GL_TRUE;
+}
+
+void saveSnapshot(GLboolean compress) {
+	char path[512];
+	snprintf(path, sizeof(path), "%s-%d.gls", patternName, generation);
+	if (beginSave(path, writeSnapshot))
+		snapshotSave.isCompressed = compress;
+}
+
+void saveRle(void) {
+	char path[512];
+	snprintf(path, sizeof(path), "%s-%d.rle", patternName, generation);
+	beginSave(path, writeRleFile);
+}
+
+void saveMacrocell(void) {
+	char path[512];
+	snprintf(path, sizeof(path), "%s-%d.mc", patternName, generation);
+	beginSave(path, writeMacrocellFile);
+}
+
+/* called once per frame to move a save along, or in a loop until it's done if wait is set */
+void pollSnapshotSave(GLboolean wait) {
+	SnapshotSave *save = &snapshotSave;
+	if (save->state == SNAPSHOT_READING) {
+		/* without sync objects we just give the GPU a couple of frames, mapping the buffer
+		   blocks until the read back is done anyway so this is only about not stalling */
+		GLboolean isReady;
+		if (save->fence) {
+			GLenum status = glClientWaitSync(save->fence, 0, wait ? ~(GLuint64)0 : 0);
+			isReady = status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+		} else {
+			isReady = wait || ++save->framesWaited >= 3;
+		}
+		if (!isReady)
+			return;
+
+		if (save->fence)
+			glDeleteSync(save->fence);
+		save->fence = NULL;
+		size_t size = (size_t)save->header.width * (size_t)(save->header.height / 32) * sizeof(uint32_t);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, save->buffer);
+		save->columns = (const uint32_t *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		save->writerIsDone = 0;
+		if (!save->columns || !startThread(&save->writer, save->write, save)) {
+			printf("couldnt save %s\n", save->path);
+			if (save->columns) {
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, save->buffer);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+			save->state = SNAPSHOT_IDLE;
+			return;
+		}
+		save->state = SNAPSHOT_WRITING;
+	}
+
+	if (save->state == SNAPSHOT_WRITING) {
+		if (!wait && !save->writerIsDone)
+			return;
+		joinThread(save->writer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, save->buffer);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		printf(save->isOk ? "saved %s\n" : "couldnt save %s\n", save->path);
+		save->state = SNAPSHOT_IDLE;
+	}
+}
+
+/* recordings (.glr) keep every generation of a run. every RECORDING_KEYFRAME_INTERVAL generations
+   the whole world is stored, and in between only the column words that changed, XORed with the
+   generation before. both are stored as zero runs, which is what makes the deltas small. an index
+   of all frames at the end of the file makes seeking cheap - decode the keyframe at or before the
+   generation and apply the deltas after it.
+   the world is read back into a small ring of pixel buffers after every generation, and encoding
+   and writing happens on a separate thread. if either falls behind the simulation waits for it */
+#define RECORDING_VERSION 1
+#define RECORDING_KEYFRAME_INTERVAL 64
+#define NUM_RECORD_BUFFERS 4
+#define NUM_RECORD_FRAMES 4
+
+typedef struct RecordingHeader {
+	char magic[8];
+	uint32_t version;
+	int32_t width;
+	int32_t height;
+	uint32_t keyframeInterval;
+	int64_t firstGeneration;
+	uint64_t indexOffset;
+	uint64_t numFrames;
+	char reserved[16];
+} RecordingHeader;
+
+typedef struct RecordingFrame {
+	uint64_t offset;
+	uint32_t size;
+	uint32_t isKeyframe;
+} RecordingFrame;
+
+typedef struct Recorder {
+	GLboolean isRecording;
+	char path[512];
+	RecordingHeader header;
+	size_t numWords;
+	/* read backs in flight on the GPU */
+	GLuint buffers[NUM_RECORD_BUFFERS];
+	GLsync fences[NUM_RECORD_BUFFERS];
+	int firstPending;
+	int numPending;
+	/* frames handed over to the writer thread */
+	uint32_t *frames[NUM_RECORD_FRAMES];
+	Handoff handoff;
+	Thread writer;
+	/* only touched by the writer thread */
+	FILE *f;
+	uint32_t *previous;
+	uint32_t *delta;
+	uint8_t *encoded;
+	RecordingFrame *index;
+	uint64_t offset;
+	GLboolean isOk;
+} Recorder;
+
+Recorder recorder;
+
+void writeRecordingFrame(Recorder *rec, const uint32_t *frame) {
+	uint64_t numFrames = rec->header.numFrames;
+	GLboolean isKeyframe = numFrames % RECORDING_KEYFRAME_INTERVAL == 0;
+	const uint32_t *words = frame;
+	if (!isKeyframe) {
+		for (size_t i = 0; i < rec->numWords; ++i)
+			rec->delta[i] = frame[i] ^ rec->previous[i];
+		words = rec->delta;
+	}
+	memcpy(rec->previous, frame, rec->numWords * sizeof(uint32_t));
+
+	if (numFrames % RECORDING_KEYFRAME_INTERVAL == 0) {
+		RecordingFrame *index = (RecordingFrame *)realloc(rec->index, (size_t)(numFrames + RECORDING_KEYFRAME_INTERVAL) * sizeof(RecordingFrame));
+		if (!index) {
+			rec->isOk = GL_FALSE;
+			return;
+		}
+		rec->index = index;
+	}
+
+	size_t size = encodeZeroRuns(words, rec->numWords, rec->encoded);
+	rec->isOk &= fwrite(rec->encoded, 1, size, rec->f) == size;
+	rec->index[numFrames].offset = rec->offset;
+	rec->index[numFrames].size = (uint32_t)size;
+	rec->index[numFrames].isKeyframe = isKeyframe;
+	rec->offset += size;
+	rec->header.numFrames = numFrames + 1;
+}
+
+void runRecordingWriter(void *arg) {
+	Recorder *rec = (Recorder *)arg;
+	for (int frame; (frame = takeHandoffItem(&rec->handoff, 1)) >= 0; finishHandoffItem(&rec->handoff)) {
+		if (rec->isOk)
+			writeRecordingFrame(rec, rec->frames[frame % NUM_RECORD_FRAMES]);
+	}
+
+	if (rec->isOk) {
+		/* keep the index aligned so that it can be used straight from a mapping */
+		const uint8_t padding[8] = { 0 };
+		size_t paddingSize = (size_t)(-(int64_t)rec->offset & 7);
+		rec->isOk &= fwrite(padding, 1, paddingSize, rec->f) == paddingSize;
+		rec->header.indexOffset = rec->offset + paddingSize;
+		size_t numFrames = (size_t)rec->header.numFrames;
+		rec->isOk &= fwrite(rec->index, sizeof(RecordingFrame), numFrames, rec->f) == numFrames;
+		rec->isOk &= fseek(rec->f, 0, SEEK_SET) == 0;
+		rec->isOk &= fwrite(&rec->header, sizeof(rec->header), 1, rec->f) == 1;
+	}
+	rec->isOk &= fclose(rec->f) == 0;
+}
+
+/* hands the oldest read back over to the writer, waiting for it if needed */
+GLboolean finishRecordRead(Recorder *rec, GLboolean wait) {
+	int slot = rec->firstPending;
+	if (rec->fences[slot]) {
+		GLenum status = glClientWaitSync(rec->fences[slot], 0, wait ? ~(GLuint64)0 : 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return GL_FALSE;
+		glDeleteSync(rec->fences[slot]);
+		rec->fences[slot] = NULL;
+	}
+	waitForHandoffSlot(&rec->handoff, NUM_RECORD_FRAMES);
+
+	size_t size = rec->numWords * sizeof(uint32_t);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, rec->buffers[slot]);
+	const void *columns = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+	if (columns) {
+		memcpy(rec->frames[rec->handoff.numQueued % NUM_RECORD_FRAMES], columns, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		queueHandoffItem(&rec->handoff);
+	} else {
+		rec->isOk = GL_FALSE;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	rec->firstPending = (slot + 1) % NUM_RECORD_BUFFERS;
+	--rec->numPending;
+	return GL_TRUE;
+}
+
+/* called after every generation while recording */
+void recordGeneration(void) {
+	Recorder *rec = &recorder;
+	if (rec->numPending == NUM_RECORD_BUFFERS)
+		finishRecordRead(rec, GL_TRUE);
+
+	int slot = (rec->firstPending + rec->numPending) % NUM_RECORD_BUFFERS;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, rec->buffers[slot]);
+	glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)(rec->numWords * sizeof(uint32_t)), NULL, GL_STREAM_READ);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, cellsReadFramebuffer);
+	glReadPixels(0, 0, numCellsX, numCellsY / 32, GL_RED_INTEGER, GL_UNSIGNED_INT, (void *)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	rec->fences[slot] = glFenceSync ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : NULL;
+	++rec->numPending;
+}
+
+/* called once per frame to move finished read backs along */
+void pollRecorder(void) {
+	Recorder *rec = &recorder;
+	while (rec->isRecording && rec->numPending > 0 && finishRecordRead(rec, GL_FALSE));
+}
+
+void freeRecorderFrames(Recorder *rec) {
+	for (int i = 0; i < NUM_RECORD_FRAMES; ++i) {
+		free(rec->frames[i]);
+		rec->frames[i] = NULL;
+	}
+	free(rec->previous);
+	free(rec->delta);
+	free(rec->encoded);
+	free(rec->index);
+	rec->previous = rec->delta = NULL;
+	rec->encoded = NULL;
+	rec->index = NULL;
+}
+
+void stopRecording(void) {
+	Recorder *rec = &recorder;
+	if (!rec->isRecording)
+		return;
+	while (rec->numPending > 0)
+		finishRecordRead(rec, GL_TRUE);
+	stopHandoff(&rec->handoff);
+	joinThread(rec->writer);
+	rec->isRecording = GL_FALSE;
+	printf(rec->isOk ? "saved %s (%d generations)\n" : "couldnt save %s\n", rec->path, (int)rec->header.numFrames);
+	freeRecorderFrames(rec);
+}
+
+void startRecording(void) {
+	Recorder *rec = &recorder;
+	if (rec->isRecording)
+		return;
+
+	memset(&rec->header, 0, sizeof(rec->header));
+	memcpy(rec->header.magic, "GLREC", 6);
+	rec->header.version = RECORDING_VERSION;
+	rec->header.width = numCellsX;
+	rec->header.height = numCellsY;
+	rec->header.keyframeInterval = RECORDING_KEYFRAME_INTERVAL;
+	rec->header.firstGeneration = generation;
+	rec->numWords = (size_t)numCellsX * (size_t)(numCellsY / 32);
+	rec->firstPending = rec->numPending = 0;
+	resetHandoff(&rec->handoff);
+	rec->offset = sizeof(RecordingHeader);
+	rec->isOk = GL_TRUE;
+
+	GLboolean isOk = GL_TRUE;
+	for (int i = 0; i < NUM_RECORD_FRAMES; ++i)
+		isOk &= (rec->frames[i] = (uint32_t *)malloc(rec->numWords * sizeof(uint32_t))) != NULL;
+	isOk &= (rec->previous = (uint32_t *)malloc(rec->numWords * sizeof(uint32_t))) != NULL;
+	isOk &= (rec->delta = (uint32_t *)malloc(rec->numWords * sizeof(uint32_t))) != NULL;
+	isOk &= (rec->encoded = (uint8_t *)malloc(zeroRunBound(rec->numWords))) != NULL;
+	if (!isOk) {
+		printf("out of memory\n");
+		freeRecorderFrames(rec);
+		return;
+	}
+
+	snprintf(rec->path, sizeof(rec->path), "%s-%d.glr", patternName, generation);
+	rec->f = fopen(rec->path, "wb");
+	if (!rec->f || fwrite(&rec->header, sizeof(rec->header), 1, rec->f) != 1 || !startThread(&rec->writer, runRecordingWriter, rec)) {
+		printf("couldnt open %s\n", rec->path);
+		if (rec->f)
+			fclose(rec->f);
+		freeRecorderFrames(rec);
+		return;
+	}
+	if (!rec->buffers[0])
+		glGenBuffers(NUM_RECORD_BUFFERS, rec->buffers);
+	printf("recording %s .. \n", rec->path);
+	rec->isRecording = GL_TRUE;
+	recordGeneration();
+}
+
+/* an opened recording can be stepped through one generation at a time */
+typedef struct Playback {
+	GLboolean isOpen;
+	MappedFile mapped;
+	const RecordingHeader *header;
+	const RecordingFrame *index;
+	PackedCells cells;
+	int64_t frame;
+} Playback;
+
+Playback playback;
+
+void closeRecording(void) {
+	if (!playback.isOpen)
+		return;
+	freePackedCells(&playback.cells);
+	unmapFile(&playback.mapped);
+	playback.isOpen = GL_FALSE;
+}
+
+GLboolean applyRecordingFrame(Playback *play, int64_t frame) {
+	const RecordingFrame *entry = &play->index[frame];
+	if (entry->offset > play->mapped.size || entry->size > play->mapped.size - entry->offset)
+		return GL_FALSE;
+	size_t numWords = (size_t)play->cells.columnsX * (size_t)play->cells.columnsY;
+	if (entry->isKeyframe)
+		memset(play->cells.columns, 0, numWords * sizeof(uint32_t));
+	return applyZeroRuns((const uint8_t *)play->mapped.data + entry->offset, entry->size, play->cells.columns, numWords);
+}
+
+/* shows the recorded generation, or the closest one to it that was recorded */
+void seekRecording(int64_t targetGeneration) {
+	Playback *play = &playback;
+	if (!play->isOpen)
+		return;
+	/* a recording going on would carry on from the seeked to world with the wrong generations */
+	stopRecording();
+	int64_t frame = targetGeneration - play->header->firstGeneration;
+	if (frame < 0)
+		frame = 0;
+	if (frame >= (int64_t)play->header->numFrames)
+		frame = (int64_t)play->header->numFrames - 1;
+
+	/* stepping forward only needs the next delta, anything else starts from a keyframe. they are
+	   found from the index rather than the header, so deltas never go onto the wrong cells */
+	int64_t first = frame;
+	while (first > 0 && !play->index[first].isKeyframe)
+		--first;
+	if (!play->index[first].isKeyframe) {
+		printf("recording is corrupted\n");
+		play->frame = -1;
+		return;
+	}
+	if (play->frame >= first && play->frame < frame)
+		first = play->frame + 1;
+	for (int64_t i = first; i <= frame; ++i) {
+		if (!applyRecordingFrame(play, i)) {
+			printf("recording is corrupted\n");
+			play->frame = -1;
+			return;
+		}
+	}
+	play->frame = frame;
+
+	if (numCellsX == play->cells.width && numCellsY == play->cells.height)
+		uploadCellBands(&play->cells);
+	else
+		setPackedCells(&play->cells);
+	generation = (int)(play->header->firstGeneration + frame);
+}
+
+GLboolean openRecording(const char *file) {
+	closeRecording();
+	Playback *play = &playback;
+	if (!mapFile(&play->mapped, file)) {
+		printf("couldnt open %s\n", file);
+		return GL_FALSE;
+	}
+	play->header = (const RecordingHeader *)play->mapped.data;
+	const RecordingHeader *header = play->header;
+	GLboolean isOk =
+		play->mapped.size >= sizeof(RecordingHeader) &&
+		memcmp(header->magic, "GLREC", 6) == 0 &&
+		header->version == RECORDING_VERSION &&
+		header->width > 0 && header->width % 32 == 0 &&
+		header->height > 0 && header->height % 32 == 0 &&
+		header->keyframeInterval > 0 && header->numFrames > 0 &&
+		header->indexOffset <= play->mapped.size &&
+		(play->mapped.size - header->indexOffset) / sizeof(RecordingFrame) >= header->numFrames;
+	if (isOk && !allocPackedCells(&play->cells, header->width, header->height)) {
+		printf("out of memory\n");
+		isOk = GL_FALSE;
+	} else if (!isOk) {
+		printf("invalid recording file\n");
+	}
+	if (!isOk) {
+		unmapFile(&play->mapped);
+		return GL_FALSE;
+	}
+
+	play->index = (const RecordingFrame *)(play->mapped.data + header->indexOffset);
+	play->frame = -1;
+	play->isOpen = GL_TRUE;
+	seekRecording(header->firstGeneration);
+	return play->frame >= 0;
+}
+
+/* frames of the world as seen on screen can be exported as a png sequence or a y4m video */
+#define NUM_EXPORT_BUFFERS 3
+#define NUM_EXPORT_FRAMES 12
+#define MAX_EXPORT_ENCODERS 8
+#define EXPORT_FRAME_RATE 30
+
+uint32_t adler32(const uint8_t *data, size_t size) {
+	uint32_t a = 1, b = 0;
+	while (size > 0) {
+		/* 5552 bytes is the most that can be summed up before b can overflow */
+		size_t n = size < 5552 ? size : 5552;
+		size -= n;
+		while (n-- > 0) {
+			a += *data++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+void putBigEndian32(uint8_t *p, uint32_t value) {
+	p[0] = (uint8_t)(value >> 24);
+	p[1] = (uint8_t)(value >> 16);
+	p[2] = (uint8_t)(value >> 8);
+	p[3] = (uint8_t)value;
+}
+
+size_t getPngRawSize(int width, int height) {
+	return (size_t)height * (1 + 3 * (size_t)width);
+}
+
+size_t pngBound(int width, int height) {
+	size_t rawSize = getPngRawSize(width, height);
+	return 8 + 25 + 12 + 2 + rawSize + 5 * (rawSize / 65535 + 1) + 4 + 12;
+}
+
+/* the chunk data has to be in place already at out + 8 */
+size_t finishPngChunk(uint8_t *out, const char *type, size_t size) {
+	putBigEndian32(out, (uint32_t)size);
+	memcpy(out + 4, type, 4);
+	putBigEndian32(out + 8 + size, updateCrc(0, out + 4, size + 4));
+	return size + 12;
+}
+
+/* bottom up rgba pixels to an rgb png. the renderer only draws flat greys so deflate wouldn't
+   have much trouble with it, but it's stored uncompressed to keep up with the simulation */
+size_t encodePng(const uint8_t *pixels, int width, int height, uint8_t *raw, uint8_t *out) {
+	size_t rowSize = 1 + 3 * (size_t)width;
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *src = pixels + (size_t)(height - 1 - y) * width * 4;
+		uint8_t *dst = raw + (size_t)y * rowSize;
+		*dst++ = 0;
+		for (int x = 0; x < width; ++x, src += 4, dst += 3) {
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+		}
+	}
+	size_t rawSize = rowSize * height;
+
+	uint8_t *p = out;
+	memcpy(p, "\x89PNG\r\n\x1A\n", 8);
+	p += 8;
+
+	putBigEndian32(p + 8, (uint32_t)width);
+	putBigEndian32(p + 12, (uint32_t)height);
+	p[16] = 8;
+	p[17] = 2;
+	p[18] = p[19] = p[20] = 0;
+	p += finishPngChunk(p, "IHDR", 13);
+
+	uint8_t *data = p + 8;
+	*data++ = 0x78;
+	*data++ = 0x01;
+	size_t offset = 0;
+	do {
+		size_t n = rawSize - offset < 65535 ? rawSize - offset : 65535;
+		data[0] = offset + n == rawSize;
+		data[1] = (uint8_t)n;
+		data[2] = (uint8_t)(n >> 8);
+		data[3] = (uint8_t)~n;
+		data[4] = (uint8_t)(~n >> 8);
+		memcpy(data + 5, raw + offset, n);
+		data += 5 + n;
+		offset += n;
+	} while (offset < rawSize);
+	putBigEndian32(data, adler32(raw, rawSize));
+	data += 4;
+	p += finishPngChunk(p, "IDAT", (size_t)(data - (p + 8)));
+	p += finishPngChunk(p, "IEND", 0);
+	return (size_t)(p - out);
+}
+
+size_t y4mFrameBound(int width, int height) {
+	return 6 + (size_t)width * height * 3 / 2;
+}
+
+/* bottom up rgba pixels to a full range bt.601 4:2:0 frame. width and height have to be even */
+size_t encodeY4mFrame(const uint8_t *pixels, int width, int height, uint8_t *out) {
+	memcpy(out, "FRAME\n", 6);
+	uint8_t *planeY = out + 6;
+	uint8_t *planeU = planeY + (size_t)width * height;
+	uint8_t *planeV = planeU + (size_t)(width / 2) * (height / 2);
+	for (int y = 0; y < height; y += 2) {
+		const uint8_t *rows[2];
+		rows[0] = pixels + (size_t)(height - 1 - y) * width * 4;
+		rows[1] = rows[0] - (size_t)width * 4;
+		for (int x = 0; x < width; x += 2) {
+			int sumR = 0, sumG = 0, sumB = 0;
+			for (int i = 0; i < 4; ++i) {
+				const uint8_t *src = rows[i >> 1] + (x + (i & 1)) * 4;
+				planeY[(size_t)(y + (i >> 1)) * width + x + (i & 1)] = (uint8_t)((77 * src[0] + 150 * src[1] + 29 * src[2] + 128) >> 8);
+				sumR += src[0];
+				sumG += src[1];
+				sumB += src[2];
+			}
+			int u = (131584 - 43 * sumR - 85 * sumG + 128 * sumB) >> 10;
+			int v = (131584 + 128 * sumR - 107 * sumG - 21 * sumB) >> 10;
+			size_t i = (size_t)(y / 2) * (width / 2) + x / 2;
+			planeU[i] = (uint8_t)(u > 255 ? 255 : u);
+			planeV[i] = (uint8_t)(v > 255 ? 255 : v);
+		}
+	}
+	return y4mFrameBound(width, height);
+}
+
+typedef struct Exporter {
+	GLboolean isExporting;
+	GLboolean isY4m;
+	char path[512];
+	int width;
+	int height;
+	int every;
+	int untilNextFrame;
+	int maxFrames;
+	int numFrames;
+	/* frames are rendered off screen and read back without waiting on the GPU */
+	GLuint texture;
+	GLuint framebuffer;
+	GLuint buffers[NUM_EXPORT_BUFFERS];
+	GLsync fences[NUM_EXPORT_BUFFERS];
+	int firstPending;
+	int numPending;
+	/* frames handed over to the encoders. frame i goes to slot i % NUM_EXPORT_FRAMES
+	   once the frame before it in that slot has been encoded */
+	uint8_t *frames[NUM_EXPORT_FRAMES];
+	volatile int numEncodedInSlot[NUM_EXPORT_FRAMES];
+	Handoff handoff;
+	volatile int numWritten;
+	volatile int numFailed;
+	Thread encoders[MAX_EXPORT_ENCODERS];
+	int numEncoders;
+	FILE *f;
+} Exporter;
+
+Exporter exporter;
+
+void runExportEncoder(void *arg) {
+	Exporter *ex = (Exporter *)arg;
+	uint8_t *raw = ex->isY4m ? NULL : (uint8_t *)malloc(getPngRawSize(ex->width, ex->height));
+	uint8_t *encoded = (uint8_t *)malloc(ex->isY4m ? y4mFrameBound(ex->width, ex->height) : pngBound(ex->width, ex->height));
+	GLboolean isOk = encoded && (ex->isY4m || raw);
+	for (int frame; (frame = takeHandoffItem(&ex->handoff, 1)) >= 0; finishHandoffItem(&ex->handoff)) {
+		int slot = frame % NUM_EXPORT_FRAMES;
+		size_t size = 0;
+		if (isOk && ex->isY4m)
+			size = encodeY4mFrame(ex->frames[slot], ex->width, ex->height, encoded);
+		else if (isOk)
+			size = encodePng(ex->frames[slot], ex->width, ex->height, raw, encoded);
+		atomicFetchAdd(&ex->numEncodedInSlot[slot], 1);
+
+		GLboolean isWritten = GL_FALSE;
+		if (ex->isY4m) {
+			/* frames are encoded in any order but have to be written in order */
+			while (atomicFetchAdd(&ex->numWritten, 0) != frame)
+				sleepMilliseconds(1);
+			isWritten = isOk && fwrite(encoded, 1, size, ex->f) == size;
+			atomicFetchAdd(&ex->numWritten, 1);
+		} else if (isOk) {
+			char path[600];
+			snprintf(path, sizeof(path), "%s-%06d.png", ex->path, frame);
+			FILE *f = fopen(path, "wb");
+			if (f) {
+				isWritten = fwrite(encoded, 1, size, f) == size;
+				isWritten &= fclose(f) == 0;
+			}
+		}
+		if (!isWritten)
+			atomicFetchAdd(&ex->numFailed, 1);
+	}
+	free(raw);
+	free(encoded);
+}
+
+/* hands the oldest read back over to the encoders, waiting for it if needed */
+GLboolean finishExportRead(Exporter *ex, GLboolean wait) {
+	int slot = ex->firstPending;
+	if (ex->fences[slot]) {
+		GLenum status = glClientWaitSync(ex->fences[slot], 0, wait ? ~(GLuint64)0 : 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return GL_FALSE;
+		glDeleteSync(ex->fences[slot]);
+		ex->fences[slot] = NULL;
+	}
+	int frame = ex->handoff.numQueued;
+	uint8_t *pixels = ex->frames[frame % NUM_EXPORT_FRAMES];
+	while (atomicFetchAdd(&ex->numEncodedInSlot[frame % NUM_EXPORT_FRAMES], 0) < frame / NUM_EXPORT_FRAMES)
+		sleepMilliseconds(1);
+
+	size_t size = (size_t)ex->width * ex->height * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ex->buffers[slot]);
+	const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+	if (mapped) {
+		memcpy(pixels, mapped, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	} else {
+		/* still queue it so that the frame numbers stay in step */
+		memset(pixels, 0, size);
+		atomicFetchAdd(&ex->numFailed, 1);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	queueHandoffItem(&ex->handoff);
+	ex->firstPending = (slot + 1) % NUM_EXPORT_BUFFERS;
+	--ex->numPending;
+	return GL_TRUE;
+}
+
+void exportFrame(Exporter *ex) {
+	if (ex->numPending == NUM_EXPORT_BUFFERS)
+		finishExportRead(ex, GL_TRUE);
+
+	renderCellsTo(ex->framebuffer, ex->width, ex->height);
+	int slot = (ex->firstPending + ex->numPending) % NUM_EXPORT_BUFFERS;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ex->buffers[slot]);
+	glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)((size_t)ex->width * ex->height * 4), NULL, GL_STREAM_READ);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, ex->framebuffer);
+	glReadPixels(0, 0, ex->width, ex->height, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	ex->fences[slot] = glFenceSync ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : NULL;
+	++ex->numPending;
+	++ex->numFrames;
+}
+
+/* called once per frame to move finished read backs along */
+void pollExporter(void) {
+	Exporter *ex = &exporter;
+	while (ex->isExporting && ex->numPending > 0 && finishExportRead(ex, GL_FALSE));
+}
+
+void freeExportFrames(Exporter *ex) {
+	for (int i = 0; i < NUM_EXPORT_FRAMES; ++i) {
+		free(ex->frames[i]);
+		ex->frames[i] = NULL;
+	}
+	if (ex->framebuffer)
+		glDeleteFramebuffers(1, &ex->framebuffer);
+	if (ex->texture)
+		glDeleteTextures(1, &ex->texture);
+	ex->framebuffer = ex->texture = 0;
+	if (ex->f)
+		fclose(ex->f);
+	ex->f = NULL;
+}
+
+void stopExport(void) {
+	Exporter *ex = &exporter;
+	if (!ex->isExporting)
+		return;
+	while (ex->numPending > 0)
+		finishExportRead(ex, GL_TRUE);
+	stopHandoff(&ex->handoff);
+	for (int i = 0; i < ex->numEncoders; ++i)
+		joinThread(ex->encoders[i]);
+	if (ex->f && fclose(ex->f) != 0)
+		++ex->numFailed;
+	ex->f = NULL;
+	ex->isExporting = GL_FALSE;
+	if (ex->numFailed == 0)
+		printf("exported %d frames to %s%s\n", ex->numFrames, ex->path, ex->isY4m ? "" : "-*.png");
+	else
+		printf("couldnt export %s (%d of %d frames failed)\n", ex->path, ex->numFailed, ex->numFrames);
+	freeExportFrames(ex);
+}
+
+/* called after every generation while exporting */
+void exportGeneration(void) {
+	Exporter *ex = &exporter;
+	if (--ex->untilNextFrame > 0)
+		return;
+	exportFrame(ex);
+	ex->untilNextFrame = ex->every;
+	if (ex->maxFrames > 0 && ex->numFrames >= ex->maxFrames)
+		stopExport();
+}
+
+/* exports every nth generation from now on, as seen in the window right now. paths ending
+   in .y4m get a video, anything else is the prefix of a numbered png sequence */
+void startExport(const char *path, int every, int maxFrames) {
+	Exporter *ex = &exporter;
+	if (ex->isExporting)
+		return;
+
+	size_t length = strlen(path);
+	ex->isY4m = length >= 4 && strcmp(path + length - 4, ".y4m") == 0;
+	if (!ex->isY4m && length >= 4 && strcmp(path + length - 4, ".png") == 0)
+		length -= 4;
+	snprintf(ex->path, sizeof(ex->path), "%.*s", (int)length, path);
+	ex->width = windowWidth & ~1;
+	ex->height = windowHeight & ~1;
+	ex->every = every > 1 ? every : 1;
+	ex->untilNextFrame = 1;
+	ex->maxFrames = maxFrames;
+	ex->numFrames = 0;
+	ex->firstPending = ex->numPending = 0;
+	resetHandoff(&ex->handoff);
+	ex->numWritten = ex->numFailed = 0;
+	for (int i = 0; i < NUM_EXPORT_FRAMES; ++i)
+		ex->numEncodedInSlot[i] = 0;
+	if (ex->width < 2 || ex->height < 2) {
+		printf("window is too small to export\n");
+		return;
+	}
+
+	GLboolean isOk = GL_TRUE;
+	for (int i = 0; i < NUM_EXPORT_FRAMES; ++i)
+		isOk &= (ex->frames[i] = (uint8_t *)malloc((size_t)ex->width * ex->height * 4)) != NULL;
+	if (!isOk) {
+		printf("out of memory\n");
+		freeExportFrames(ex);
+		return;
+	}
+
+	if (ex->isY4m) {
+		ex->f = fopen(ex->path, "wb");
+		if (!ex->f || fprintf(ex->f, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", ex->width, ex->height, EXPORT_FRAME_RATE) < 0) {
+			printf("couldnt open %s\n", ex->path);
+			freeExportFrames(ex);
+			return;
+		}
+	}
+
+	ex->numEncoders = getNumCores() - 1;
+	if (ex->numEncoders < 1)
+		ex->numEncoders = 1;
+	if (ex->numEncoders > MAX_EXPORT_ENCODERS)
+		ex->numEncoders = MAX_EXPORT_ENCODERS;
+	int numStarted = 0;
+	while (numStarted < ex->numEncoders && startThread(&ex->encoders[numStarted], runExportEncoder, ex))
+		++numStarted;
+	ex->numEncoders = numStarted;
+	if (numStarted == 0) {
+		printf("couldnt start encoding %s\n", ex->path);
+		freeExportFrames(ex);
+		return;
+	}
+
+	ex->texture = createTexture(NULL, ex->width, ex->height, GL_RGBA, GL_RGBA8);
+	ex->framebuffer = createFramebuffer(ex->texture);
+	if (!ex->buffers[0])
+		glGenBuffers(NUM_EXPORT_BUFFERS, ex->buffers);
+	printf("exporting %s every %d generations .. \n", ex->path, ex->every);
+	ex->isExporting = GL_TRUE;
+	exportGeneration();
+}
+
+/* the phases of every frame can be traced to a chrome://tracing or perfetto json file. events go
+   into a ring that only the main thread adds to and only the writer thread takes from, with a
+   counter for each side, so the main thread never waits on the file. gpu intervals come from
+   timestamp queries that are picked up a few frames later, once they are available */
+#define NUM_TRACE_EVENTS (1 << 16)
+#define NUM_TRACE_QUERIES 64
+#define TRACE_CPU 1
+#define TRACE_GPU 2
+
+typedef struct TraceEvent {
+	const char *name;
+	int thread;
+	/* nanoseconds since tracing started */
+	int64_t start;
+	int64_t duration;
+} TraceEvent;
+
+typedef struct TracePhase {
+	int64_t start;
+	int query;
+} TracePhase;
+
+typedef struct Tracer {
+	GLboolean isTracing;
+	char path[512];
+	uint64_t startTime;
+	int numDropped;
+	TraceEvent *events;
+	Handoff handoff;
+	Thread writer;
+	/* begin and end timestamp queries go in pairs, the gpu clock is lined up with ours at the start */
+	GLuint queries[NUM_TRACE_QUERIES];
+	const char *queryNames[NUM_TRACE_QUERIES / 2];
+	int firstPending;
+	int numPending;
+	int64_t gpuStartTime;
+	GLboolean hasGpuTimes;
+	/* only touched by the writer thread */
+	FILE *f;
+	GLboolean isOk;
+} Tracer;
+
+Tracer tracer;
+
+int64_t getTraceTime(void) {
+	return (int64_t)((double)(glfwGetTimerValue() - tracer.startTime) * 1.0e+9 / (double)glfwGetTimerFrequency());
+}
+
+void traceEvent(const char *name, int thread, int64_t start, int64_t duration) {
+	Tracer *tr = &tracer;
+	if (isHandoffFull(&tr->handoff, NUM_TRACE_EVENTS)) {
+		++tr->numDropped;
+		return;
+	}
+	TraceEvent *event = &tr->events[tr->handoff.numQueued % NUM_TRACE_EVENTS];
+	event->name = name;
+	event->thread = thread;
+	event->start = start;
+	event->duration = duration;
+	queueHandoffItem(&tr->handoff);
+}
+
+/* costs a single branch when nothing is being traced */
+void beginTracePhase(TracePhase *phase, GLboolean isOnGpu) {
+	Tracer *tr = &tracer;
+	phase->start = -1;
+	phase->query = -1;
+	if (!tr->isTracing)
+		return;
+	phase->start = getTraceTime();
+	if (isOnGpu && tr->hasGpuTimes && tr->numPending + 2 <= NUM_TRACE_QUERIES) {
+		phase->query = (tr->firstPending + tr->numPending) % NUM_TRACE_QUERIES;
+		glQueryCounter(tr->queries[phase->query], GL_TIMESTAMP);
+		++tr->numPending;
+	}
+}
+
+void endTracePhase(TracePhase *phase, const char *name) {
+	Tracer *tr = &tracer;
+	if (!tr->isTracing || phase->start < 0)
+		return;
+	if (phase->query >= 0) {
+		glQueryCounter(tr->queries[phase->query + 1], GL_TIMESTAMP);
+		tr->queryNames[phase->query / 2] = name;
+		++tr->numPending;
+	}
+	traceEvent(name, TRACE_CPU, phase->start, getTraceTime() - phase->start);
+}
+
+/* turns the oldest gpu intervals that have finished into events */
+void finishTraceQueries(Tracer *tr, GLboolean wait) {
+	while (tr->numPending >= 2) {
+		int query = tr->firstPending;
+		GLuint isAvailable = GL_TRUE;
+		if (!wait)
+			glGetQueryObjectuiv(tr->queries[query + 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (!isAvailable)
+			break;
+		GLuint64 start, end;
+		glGetQueryObjectui64v(tr->queries[query], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(tr->queries[query + 1], GL_QUERY_RESULT, &end);
+		traceEvent(tr->queryNames[query / 2], TRACE_GPU, (int64_t)(start - (GLuint64)tr->gpuStartTime), (int64_t)(end - start));
+		tr->firstPending = (query + 2) % NUM_TRACE_QUERIES;
+		tr->numPending -= 2;
+	}
+}
+
+void writeTraceEvent(Tracer *tr, const TraceEvent *event) {
+	fprintf(tr->f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+		event->name, event->thread, event->start * 1.0e-3, event->duration * 1.0e-3);
+}
+
+void runTraceWriter(void *arg) {
+	Tracer *tr = (Tracer *)arg;
+	fprintf(tr->f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+		"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU Life\"}},\n"
+		"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"CPU\"}},\n"
+		"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", TRACE_CPU, TRACE_GPU);
+	for (int event; (event = takeHandoffItem(&tr->handoff, 10)) >= 0; finishHandoffItem(&tr->handoff))
+		writeTraceEvent(tr, &tr->events[event % NUM_TRACE_EVENTS]);
+	fprintf(tr->f, "\n]}\n");
+	tr->isOk = !ferror(tr->f);
+	tr->isOk &= fclose(tr->f) == 0;
+}
+
+void pollTracer(void) {
+	if (tracer.isTracing)
+		finishTraceQueries(&tracer, GL_FALSE);
+}
+
+void stopTrace(void) {
+	Tracer *tr = &tracer;
+	if (!tr->isTracing)
+		return;
+	finishTraceQueries(tr, GL_TRUE);
+	tr->isTracing = GL_FALSE;
+	stopHandoff(&tr->handoff);
+	joinThread(tr->writer);
+	printf(tr->isOk ? "saved %s (%d events" : "couldnt save %s (%d events", tr->path, tr->handoff.numDone);
+	printf(tr->numDropped ? ", %d dropped)\n" : ")\n", tr->numDropped);
+	free(tr->events);
+	tr->events = NULL;
+}
+
+void startTrace(const char *path) {
+	Tracer *tr = &tracer;
+	if (tr->isTracing)
+		return;
+	snprintf(tr->path, sizeof(tr->path), "%s", path);
+	tr->events = (TraceEvent *)malloc(NUM_TRACE_EVENTS * sizeof(TraceEvent));
+	if (!tr->events) {
+		printf("out of memory\n");
+		return;
+	}
+	resetHandoff(&tr->handoff);
+	tr->numDropped = 0;
+	tr->isOk = GL_TRUE;
+	tr->f = fopen(tr->path, "wb");
+	if (!tr->f || !startThread(&tr->writer, runTraceWriter, tr)) {
+		printf("couldnt open %s\n", tr->path);
+		if (tr->f)
+			fclose(tr->f);
+		free(tr->events);
+		tr->events = NULL;
+		return;
+	}
+
+	tr->hasGpuTimes = glQueryCounter != NULL;
+	if (tr->hasGpuTimes) {
+		if (!tr->queries[0])
+			glGenQueries(NUM_TRACE_QUERIES, tr->queries);
+		tr->firstPending = tr->numPending = 0;
+		GLint64 gpuTime;
+		glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+		tr->gpuStartTime = gpuTime;
+	}
+	tr->startTime = glfwGetTimerValue();
+	printf("tracing %s .. \n", tr->path);
+	tr->isTracing = GL_TRUE;
+}
+
+/* the gpu time of every batch of updates and of every render, from a ring of time elapsed queries
+   that are only read back once they are available, so measuring never stalls the pipeline. when
+   the ring is full the batch just isn't measured */
+#define NUM_GPU_TIMER_QUERIES 16
+#define GPU_TIMER_RENDER 0
+
+typedef struct GpuTimes {
+	double updateSeconds;
+	int numUpdates;
+	double numCellUpdates;
+	int64_t numGenerations;
+	double renderSeconds;
+	int numRenders;
+} GpuTimes;
+
+typedef struct GpuTimer {
+	GLuint queries[NUM_GPU_TIMER_QUERIES];
+	/* the generations each query covers, or GPU_TIMER_RENDER, and how big the world was */
+	int generations[NUM_GPU_TIMER_QUERIES];
+	double numCells[NUM_GPU_TIMER_QUERIES];
+	int firstPending;
+	int numPending;
+	/* one set of times each for the window title, the log and the hud */
+	GpuTimes title;
+	GpuTimes log;
+	GpuTimes hud;
+	GLboolean isLogging;
+} GpuTimer;
+
+GpuTimer gpuTimer;
+
+int beginGpuTimer(void) {
+	GpuTimer *timer = &gpuTimer;
+	if (!glQueryCounter || timer->numPending == NUM_GPU_TIMER_QUERIES)
+		return -1;
+	if (!timer->queries[0])
+		glGenQueries(NUM_GPU_TIMER_QUERIES, timer->queries);
+	int query = (timer->firstPending + timer->numPending++) % NUM_GPU_TIMER_QUERIES;
+	glBeginQuery(GL_TIME_ELAPSED, timer->queries[query]);
+	return query;
+}
+
+void endGpuTimer(int query, int generations) {
+	if (query < 0)
+		return;
+	glEndQuery(GL_TIME_ELAPSED);
+	gpuTimer.generations[query] = generations;
+	gpuTimer.numCells[query] = (double)numCellsX * (double)numCellsY;
+}
+
+void addGpuTimes(GpuTimes *times, int generations, double numCells, double seconds) {
+	if (generations == GPU_TIMER_RENDER) {
+		times->renderSeconds += seconds;
+		times->numRenders += 1;
+	} else {
+		times->updateSeconds += seconds;
+		times->numUpdates += 1;
+		times->numGenerations += generations;
+		times->numCellUpdates += numCells * generations;
+	}
+}
+
+/* effective bandwidth counts every column word as read once and written once per generation,
+   anything more that the neighbour fetches cost is down to how well the texture cache does */
+void formatGpuTimes(const GpuTimes *times, char *text, size_t size) {
+	int length = 0;
+	text[0] = 0;
+	if (times->numGenerations > 0) {
+		length = snprintf(text, size, "gpu %.3lf ms per generation, %.2lf Gcells/s, %.1lf GB/s",
+			times->updateSeconds * 1.0e+3 / times->numGenerations,
+			times->numCellUpdates * 1.0e-9 / times->updateSeconds,
+			times->numCellUpdates / 32.0 * 8.0 * 1.0e-9 / times->updateSeconds);
+	}
+	if (times->numRenders > 0 && length >= 0 && (size_t)length < size) {
+		snprintf(text + length, size - length, "%srender %.3lf ms", length > 0 ? ", " : "gpu ",
+			times->renderSeconds * 1.0e+3 / times->numRenders);
+	}
+}
+
+/* picks up every finished query, called once per frame */
+void pollGpuTimer(void) {
+	GpuTimer *timer = &gpuTimer;
+	while (timer->numPending > 0) {
+		int query = timer->firstPending;
+		GLuint isAvailable = GL_FALSE;
+		glGetQueryObjectuiv(timer->queries[query], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (!isAvailable)
+			break;
+		GLuint64 nanoseconds;
+		glGetQueryObjectui64v(timer->queries[query], GL_QUERY_RESULT, &nanoseconds);
+		addGpuTimes(&timer->title, timer->generations[query], timer->numCells[query], nanoseconds * 1.0e-9);
+		addGpuTimes(&timer->log, timer->generations[query], timer->numCells[query], nanoseconds * 1.0e-9);
+		addGpuTimes(&timer->hud, timer->generations[query], timer->numCells[query], nanoseconds * 1.0e-9);
+		timer->firstPending = (query + 1) % NUM_GPU_TIMER_QUERIES;
+		--timer->numPending;
+	}
+}
+
+/* prints the times since the last call, if logging is on and anything was measured */
+void logGpuTimes(void) {
+	GpuTimer *timer = &gpuTimer;
+	char text[256];
+	formatGpuTimes(&timer->log, text, sizeof(text));
+	if (timer->isLogging && text[0])
+		printf("generation %d: %s\n", generation, text);
+	memset(&timer->log, 0, sizeof(timer->log));
+}
+
+/* the hud is an overlay with a graph of the last few seconds of frame times and what the frames
+   are spent on. all of it is drawn as flat rectangles, the text as well with one rectangle per
+   lit pixel of a tiny 3x5 font, so it needs no textures and is cheap to put together every frame */
+#define HUD_NUM_FRAMES 240
+#define HUD_NUM_LINES 4
+#define HUD_PIXEL_SIZE 2
+#define HUD_MARGIN 8
+#define HUD_GRAPH_HEIGHT 60
+/* the graph goes up to three 60 Hz frames, longer frames are clipped */
+#define HUD_GRAPH_SECONDS (3.0 / 60.0)
+
+/* 5 rows of 3 bits from the top left for ascii 32 to 95, lower case letters use the upper case ones */
+const uint16_t hudFont[64] = {
+	0x0000, 0x2482, 0x5a00, 0x5f7d, 0x3c9e, 0x52a5, 0x2aab, 0x2400,
+	0x1491, 0x4494, 0x0aa8, 0x05d0, 0x0014, 0x01c0, 0x0002, 0x12a4,
+	0x7b6f, 0x2c97, 0x73e7, 0x72cf, 0x5bc9, 0x79cf, 0x79ef, 0x7292,
+	0x7bef, 0x7bcf, 0x0410, 0x0414, 0x1511, 0x0e38, 0x4454, 0x72c2,
+	0x2be3, 0x2bed, 0x6bae, 0x3923, 0x6b6e, 0x79a7, 0x79a4, 0x396b,
+	0x5bed, 0x7497, 0x126a, 0x5bad, 0x4927, 0x5fed, 0x6b6d, 0x2b6a,
+	0x6ba4, 0x2b73, 0x6bad, 0x388e, 0x7492, 0x5b6f, 0x5b6a, 0x5bfd,
+	0x5aad, 0x5a92, 0x72a7, 0x6926, 0x4889, 0x324b, 0x2a00, 0x0007,
+};
+
+typedef struct HudVertex {
+	float x;
+	float y;
+	uint8_t color[4];
+} HudVertex;
+
+typedef struct Hud {
+	GLboolean isOn;
+	HudVertex *vertices;
+	int numVertices;
+	int capacity;
+	/* a ring of the latest frame times, oldest first from nextFrame on */
+	float frameTimes[HUD_NUM_FRAMES];
+	int nextFrame;
+	/* the text only changes a few times a second so that it can be read */
+	double statsSeconds;
+	int statsFrames;
+	double maxFrameTime;
+	int statsGeneration;
+	char lines[HUD_NUM_LINES][128];
+} Hud;
+
+Hud hud;
+
+/* color is 0xRRGGBBAA */
+void addHudRect(float x, float y, float width, float height, uint32_t color) {
+	Hud *h = &hud;
+	if (h->numVertices + 6 > h->capacity) {
+		int capacity = h->capacity ? 2 * h->capacity : 4096;
+		HudVertex *vertices = (HudVertex *)realloc(h->vertices, capacity * sizeof(HudVertex));
+		if (!vertices)
+			return;
+		h->vertices = vertices;
+		h->capacity = capacity;
+	}
+	const float corners[6][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+	for (int i = 0; i < 6; ++i) {
+		HudVertex *vertex = &h->vertices[h->numVertices++];
+		vertex->x = x + corners[i][0] * width;
+		vertex->y = y + corners[i][1] * height;
+		vertex->color[0] = (uint8_t)(color >> 24);
+		vertex->color[1] = (uint8_t)(color >> 16);
+		vertex->color[2] = (uint8_t)(color >> 8);
+		vertex->color[3] = (uint8_t)color;
+	}
+}
+
+void addHudText(float x, float y, const char *text, uint32_t color) {
+	for (; *text; ++text, x += 4 * HUD_PIXEL_SIZE) {
+		int c = (*text >= 'a' && *text <= 'z') ? *text - 'a' + 'A' : *text;
+		uint16_t glyph = hudFont[(c >= 32 && c < 96) ? c - 32 : '?' - 32];
+		for (int i = 0; i < 15; ++i) {
+			if (glyph & (0x4000 >> i))
+				addHudRect(x + (i % 3) * HUD_PIXEL_SIZE, y + (i / 3) * HUD_PIXEL_SIZE, HUD_PIXEL_SIZE, HUD_PIXEL_SIZE, color);
+		}
+	}
+}
+
+/* refreshes the text from everything measured since the last time */
+void updateHudText(void) {
+	Hud *h = &hud;
+	GpuTimes *times = &gpuTimer.hud;
+	snprintf(h->lines[0], sizeof(h->lines[0]), "frame %.2lf ms, max %.2lf ms, %.1lf fps",
+		h->statsSeconds * 1.0e+3 / h->statsFrames, h->maxFrameTime * 1.0e+3, h->statsFrames / h->statsSeconds);
+	if (!glQueryCounter) {
+		snprintf(h->lines[1], sizeof(h->lines[1]), "gpu update/render times need timer queries");
+	} else if (times->numUpdates > 0 || times->numRenders > 0) {
+		/* otherwise the last gpu times stay up, they come in a few frames late */
+		char update[64] = "-";
+		char render[64] = "-";
+		if (times->numUpdates > 0)
+			snprintf(update, sizeof(update), "%.3lf ms", times->updateSeconds * 1.0e+3 / times->numUpdates);
+		if (times->numRenders > 0)
+			snprintf(render, sizeof(render), "%.3lf ms", times->renderSeconds * 1.0e+3 / times->numRenders);
+		snprintf(h->lines[1], sizeof(h->lines[1]), "gpu update %s, render %s per frame", update, render);
+	}
+	/* seeks and loads move the generation back, those stretches don't count */
+	double generations = generation > h->statsGeneration ? generation - h->statsGeneration : 0.0;
+	double generationsPerSecond = generations / h->statsSeconds;
+	snprintf(h->lines[2], sizeof(h->lines[2]), "%.0lf generations/s, %.2lf Gcells/s",
+		generationsPerSecond, generationsPerSecond * (double)numCellsX * (double)numCellsY * 1.0e-9);
+	snprintf(h->lines[3], sizeof(h->lines[3]), "%s kernel, %d x %d cells", updateKernelName, numCellsX, numCellsY);
+	memset(times, 0, sizeof(*times));
+	h->statsSeconds = 0.0;
+	h->statsFrames = 0;
+	h->maxFrameTime = 0.0;
+	h->statsGeneration = generation;
+}
+
+/* called every frame whether the hud is showing or not, so the graph is full when it comes up */
+void recordHudFrame(double seconds) {
+	Hud *h = &hud;
+	h->frameTimes[h->nextFrame] = (float)seconds;
+	h->nextFrame = (h->nextFrame + 1) % HUD_NUM_FRAMES;
+	h->statsSeconds += seconds;
+	h->statsFrames += 1;
+	if (seconds > h->maxFrameTime)
+		h->maxFrameTime = seconds;
+	if (h->statsSeconds >= 0.25)
+		updateHudText();
+}
+
+void drawHud(void) {
+	Hud *h = &hud;
+	if (!h->isOn)
+		return;
+
+	float lineHeight = 7 * HUD_PIXEL_SIZE;
+	float width = HUD_NUM_FRAMES * HUD_PIXEL_SIZE;
+	for (int i = 0; i < HUD_NUM_LINES; ++i) {
+		float lineWidth = (float)strlen(h->lines[i]) * 4 * HUD_PIXEL_SIZE;
+		if (lineWidth > width)
+			width = lineWidth;
+	}
+	float x = HUD_MARGIN + HUD_PIXEL_SIZE * 4;
+	float y = HUD_MARGIN + HUD_PIXEL_SIZE * 4;
+	float graphTop = y + HUD_NUM_LINES * lineHeight + HUD_PIXEL_SIZE * 2;
+	float graphBottom = graphTop + HUD_GRAPH_HEIGHT;
+
+	h->numVertices = 0;
+	addHudRect(HUD_MARGIN, HUD_MARGIN, width + HUD_PIXEL_SIZE * 8, graphBottom + HUD_PIXEL_SIZE * 4 - HUD_MARGIN, 0x000000b0);
+	for (int i = 0; i < HUD_NUM_LINES; ++i)
+		addHudText(x, y + i * lineHeight, h->lines[i], 0xe0e0e0ff);
+
+	/* a line for every 60 Hz frame, and a bar for every frame that is green when it made 60 Hz,
+	   yellow when it made 30 Hz and red when it didn't */
+	for (int i = 1; i < 3; ++i) {
+		float lineY = graphBottom - (float)(i / 60.0 / HUD_GRAPH_SECONDS) * HUD_GRAPH_HEIGHT;
+		addHudRect(x, lineY, HUD_NUM_FRAMES * HUD_PIXEL_SIZE, 1, 0xffffff40);
+	}
+	for (int i = 0; i < HUD_NUM_FRAMES; ++i) {
+		float seconds = h->frameTimes[(h->nextFrame + i) % HUD_NUM_FRAMES];
+		float height = seconds < HUD_GRAPH_SECONDS ? (float)(seconds / HUD_GRAPH_SECONDS) * HUD_GRAPH_HEIGHT : HUD_GRAPH_HEIGHT;
+		uint32_t color = seconds <= 1.05 / 60.0 ? 0x40e040ff : seconds <= 1.05 / 30.0 ? 0xe0e040ff : 0xe04040ff;
+		addHudRect(x + i * HUD_PIXEL_SIZE, graphBottom - height, HUD_PIXEL_SIZE, height, color);
+	}
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+	glUseProgram(hudProgram);
+	glUniform2f(uniformHudWindowSize, (float)windowWidth, (float)windowHeight);
+	glBindVertexArray(hudVertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, hudVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, h->numVertices * sizeof(HudVertex), h->vertices, GL_STREAM_DRAW);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDrawArrays(GL_TRIANGLES, 0, h->numVertices);
+	glDisable(GL_BLEND);
+	glBindVertexArray(vertexArray);
+	glCheckErrors();
+}
+
+/* recording and exporting read the world back between generations, which would count as update
+   time if whole batches were timed. so while they are going on, generations are timed one by one
+   for as long as there are queries free, and the batches aren't timed at all */
+GLboolean isTimingEachGeneration(void) {
+	return recorder.isRecording || exporter.isExporting;
+}
+
+/* advances the world by one generation and records or exports it if that is going on */
+void stepCells(void) {
+	int query = isTimingEachGeneration() ? beginGpuTimer() : -1;
+	updateCells();
+	endGpuTimer(query, 1);
+	if (recorder.isRecording)
+		recordGeneration();
+	if (exporter.isExporting)
+		exportGeneration();
+}
+
+void clearCells() {
+	stopRecording();
+	setPatternName("unnamed pattern");
+	glBindFramebuffer(GL_FRAMEBUFFER, cellsReadFramebuffer);
+	/* this seems to work - even though the format is unsigned 
+	   integer and not floating point.. should look into glClearBuffer */
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	generation = 0;
+}
+
+void onGlfwError(int code, const char *desc) {
+	printf("GLFW error 0x%X: %s\n", code, desc);
+}
+
+void onFramebufferResized(GLFWwindow *window, int newWidth, int newHeight) {
+	glViewport(0, 0, newWidth, newHeight);
+	windowWidth = newWidth;
+	windowHeight = newHeight;
+	centerCellsOnScreen();
+}
+
+/* the cell under the mouse cursor, which can be outside of the world */
+void getMouseCell(int *x, int *y) {
+	float mX = (float)(mouseX / windowWidth);
+	float mY = (float)(mouseY / windowHeight);
+	*x = (int)floorf(numCellsX * (offsetX + mX * scaleX * scale));
+	*y = (int)floorf(numCellsY * (offsetY + mY * scaleY * scale));
+}
+
+void onMouseButton(GLFWwindow *window, int button, int action, int mods) {
+	if (action == GLFW_PRESS)
+		pressedButton = button;
+	else if (action == GLFW_RELEASE) {
+		if (button == pressedButton)
+			pressedButton = -1;
+		return;
+	}
+
+	if (button != GLFW_MOUSE_BUTTON_LEFT && button != GLFW_MOUSE_BUTTON_RIGHT || keyModsArePressed())
+		return;
+
+	int x, y;
+	getMouseCell(&x, &y);
+	if (x >= 0 && x < numCellsX && y >= 0 && y < numCellsY) {
+
+		uint8_t value = 0;
+		if (button == GLFW_MOUSE_BUTTON_LEFT) {
+			value = 0xFF;
+		}
+
+		uint32_t cellColumn;
+		glBindFramebuffer(GL_FRAMEBUFFER, cellsReadFramebuffer);
+		glReadPixels(x, y / 32, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &cellColumn);
+		if (value)
+			cellColumn |= (1 << (y & 31));
+		else
+			cellColumn &= ~(1 << (y & 31));
+		glBindTexture(GL_TEXTURE_2D, cellsRead);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y / 32, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &cellColumn);
+	}
+}
+
+void onMouseMove(GLFWwindow *window, double newX, double newY) {
+	newY = (double)windowHeight - newY;
+	double oldX = mouseX;
+	double oldY = mouseY;
+	double deltaX = newX - oldX;
+	double deltaY = newY - oldY;
+	mouseX = newX;
+	mouseY = newY;
+
+	if (pressedButton != GLFW_MOUSE_BUTTON_LEFT && pressedButton != GLFW_MOUSE_BUTTON_RIGHT && pressedButton != GLFW_MOUSE_BUTTON_MIDDLE)
+		return;
+
+	if (pressedButton == GLFW_MOUSE_BUTTON_MIDDLE || keyModsArePressed()) {
+		offsetX -= scale * scaleX * (float)(deltaX / windowWidth);
+		offsetY -= scale * scaleY * (float)(deltaY / windowHeight);
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, cellsReadFramebuffer);
+	glBindTexture(GL_TEXTURE_2D, cellsRead);
+
+	uint8_t value = 0;
+	if (pressedButton == GLFW_MOUSE_BUTTON_LEFT)
+		value = 0xFF;
+
+	/* Bresenham's line algorithm */
+	float mX0 = (float)(oldX / windowWidth);
+	float mY0 = (float)(oldY / windowHeight);
+	float mX1 = (float)(newX / windowWidth);
+	float mY1 = (float)(newY / windowHeight);
+	int x = (int)(numCellsX * (offsetX + mX0 * scaleX * scale));
+	int y = (int)(numCellsY * (offsetY + mY0 * scaleY * scale));
+	int xend = (int)(numCellsX * (offsetX + mX1 * scaleX * scale));
+	int yend = (int)(numCellsY * (offsetY + mY1 * scaleY * scale));
+
+	int dX = +abs(xend - x);
+	int dY = -abs(yend - y);
+	int signX = x < xend ? +1 : -1;
+	int signY = y < yend ? +1 : -1;
+	int error = dX + dY;
+
+	for (;;) {
+		if (x >= 0 && x < numCellsX && y >= 0 && y < numCellsY) {
+			/* this can actually be pretty slow for long lines on huge cell fields
+			   it would probably be much faster to "render" a line primitive instead
+			   of setting each pixel manually, but that is quite complicated becaue
+			   of the way that the cells are stored in a single bit.. */
+			uint32_t cellColumn;
+			glReadPixels(x, y / 32, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &cellColumn);
+			if (value)
+				cellColumn |= (1 << (y & 31));
+			else
+				cellColumn &= ~(1 << (y & 31));
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y / 32, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &cellColumn);
+		}
+
+		if (x == xend && y == yend)
+			break;
+
+		int error2 = 2 * error;
+		if (error2 >= dY) {
+			error += dY;
+			x += signX;
+		}
+		if (error2 <= dX) {
+			error += dX;
+			y += signY;
+		}
+	}
+}
+
+void onMouseWheel(GLFWwindow *window, double dX, double dY) {
+	if (keyModsArePressed()) {
+		float mX = (float)(mouseX / windowWidth);
+		float mY = (float)(mouseY / windowHeight);
+		float centerX = offsetX + mX * scaleX * scale;
+		float centerY = offsetY + mY * scaleY * scale;
+		/* we get visible rendering glitches with very small scales so we need to clamp */
+		if (dY > 0)
+			scale = fmaxf(scale / 1.1f, 0.0001f);
+		else if (dY < 0)
+			scale = fminf(scale * 1.1f, 10.0f);
+		offsetX = centerX - mX * scaleX * scale;
+		offsetY = centerY - mY * scaleY * scale;
+	} else {
+		if (dY > 0) {
+			if (framesPerUpdate > 1)
+				framesPerUpdate /= 2;
+			else
+				updatesPerFrame *= 2;
+		} else if (dY < 0) {
+			if (updatesPerFrame > 1)
+				updatesPerFrame /= 2;
+			else
+				framesPerUpdate *= 2;
+		}
+	}
+}
+
+void onKey(GLFWwindow *window, int key, int scancode, int action, int mods) {
+	if (action != GLFW_PRESS && action != GLFW_REPEAT)
+		return;
+
+	switch (key) {
+		case GLFW_KEY_ESCAPE: {
+			GLFWmonitor *monitor = glfwGetWindowMonitor(window);
+			if (monitor) {
+				int width, height;
+				glfwGetMonitorWorkarea(monitor, NULL, NULL, &width, &height);
+				glfwSetWindowMonitor(window, NULL, (windowWidth - 1280) / 2, (height - 720) / 2, 1280, 720, 60);
+			} 
+			else 
+				glfwSetWindowShouldClose(window, GLFW_TRUE);
+		}break;
+		case GLFW_KEY_ENTER:
+		case GLFW_KEY_PAUSE:
+			isRunning = !isRunning;
+			break;
+		case GLFW_KEY_C:
+		case GLFW_KEY_HOME:
+			centerCellsOnScreen();
+			break;
+		case GLFW_KEY_B:
+			cellBorderIsOn = !cellBorderIsOn;
+			break;
+		case GLFW_KEY_V:
+			vsyncIsOn = !vsyncIsOn;
+			glfwSwapInterval(vsyncIsOn);
+			break;
+		case GLFW_KEY_M:
+			if (mods & GLFW_MOD_CONTROL)
+				saveMacrocell();
+			break;
+		case GLFW_KEY_R:
+			if (mods & GLFW_MOD_CONTROL)
+				saveRle();
+			else if (recorder.isRecording)
+				stopRecording();
+			else
+				startRecording();
+			break;
+		case GLFW_KEY_E:
+			if (exporter.isExporting) {
+				stopExport();
+			} else {
+				char path[512];
+				snprintf(path, sizeof(path), "%s-%d%s", patternName, generation, (mods & GLFW_MOD_SHIFT) ? ".y4m" : "");
+				startExport(path, updatesPerFrame, 0);
+			}
+			break;
+		case GLFW_KEY_T:
+			if (tracer.isTracing) {
+				stopTrace();
+			} else {
+				char path[512];
+				snprintf(path, sizeof(path), "%s-%d-trace.json", patternName, generation);
+				startTrace(path);
+			}
+			break;
+		case GLFW_KEY_I:
+			gpuTimer.isLogging = !gpuTimer.isLogging;
+			if (gpuTimer.isLogging && !glQueryCounter)
+				printf("timer queries aren't supported, nothing to log\n");
+			break;
+		case GLFW_KEY_H:
+			hud.isOn = !hud.isOn;
+			break;
+		case GLFW_KEY_PAGE_UP:
+			seekRecording((int64_t)generation - ((mods & GLFW_MOD_SHIFT) ? RECORDING_KEYFRAME_INTERVAL : 1));
+			break;
+		case GLFW_KEY_PAGE_DOWN:
+			seekRecording((int64_t)generation + ((mods & GLFW_MOD_SHIFT) ? RECORDING_KEYFRAME_INTERVAL : 1));
+			break;
+		case GLFW_KEY_P: {
+			const char *modeNames[NUM_PASTE_MODES] = { "copy", "or", "xor" };
+			pasteMode = (PasteMode)((pasteMode + 1) % NUM_PASTE_MODES);
+			printf("paste mode %s\n", modeNames[pasteMode]);
+			break;
+		}
+		case GLFW_KEY_G:
+			gpuDecodeIsOn = !gpuDecodeIsOn;
+			printf("decoding patterns on the %s\n", gpuDecodeIsOn ? "GPU" : "CPU");
+			break;
+		case GLFW_KEY_EQUAL:
+		case GLFW_KEY_KP_ADD:
+			onMouseWheel(window, 0.0, 1.0);
+			break;
+		case GLFW_KEY_MINUS:
+		case GLFW_KEY_KP_SUBTRACT:
+			onMouseWheel(window, 0.0, -1.0);
+			break;
+		case GLFW_KEY_LEFT:
+			offsetX -= scale * scaleX * 0.05f;
+			break;
+		case GLFW_KEY_RIGHT:
+			offsetX += scale * scaleX * 0.05f;
+			break;
+		case GLFW_KEY_UP:
+			offsetY += scale * scaleY * 0.05f;
+			break;
+		case GLFW_KEY_DOWN:
+			offsetY -= scale * scaleY * 0.05f;
+			break;
+		case GLFW_KEY_L:
+			backgroundColor = 0.9f;
+			deadColor = 1.0f;
+			aliveColor = 0.0f;
+			break;
+		case GLFW_KEY_D:
+			backgroundColor = 0.0f;
+			deadColor = 0.1f;
+			aliveColor = 1.0f;
+			break;
+		case GLFW_KEY_SPACE:
+		case GLFW_KEY_KP_ENTER:
+		case GLFW_KEY_PERIOD:
+		case GLFW_KEY_TAB:
+			stepCells();
+			break;
+		case GLFW_KEY_S:
+			if (mods & GLFW_MOD_CONTROL)
+				saveSnapshot((mods & GLFW_MOD_SHIFT) != 0);
+			else
+				stepCells();
+			break;
+		case GLFW_KEY_F11:
+		case GLFW_KEY_F: {
+			GLFWmonitor *monitor = glfwGetWindowMonitor(window);
+			GLFWmonitor *primaryMonitor = glfwGetPrimaryMonitor();
+			int width, height;
+			glfwGetMonitorWorkarea(primaryMonitor, NULL, NULL, &width, &height);
+			const GLFWvidmode *mode = glfwGetVideoMode(primaryMonitor);
+			if (!monitor)
+				glfwSetWindowMonitor(window, primaryMonitor, 0, 0, width, height, mode->refreshRate);
+			else
+				glfwSetWindowMonitor(window, NULL, (width - 1280) / 2, (height - 720) / 2, 1280, 720, mode->refreshRate);
+		} break;
+		case GLFW_KEY_BACKSPACE:
+		case GLFW_KEY_DELETE:
+			clearCells();
+			break;
+		default: break;
+	}
+}
+
+#ifdef BENCHMARK
+/* the straightforward way of packing images, one pixel at a time, to check packRows against */
+void packRowsSlowly(const uint8_t *firstRow, ptrdiff_t stride, int width, int height, uint8_t threshold, GLboolean isBitmap, PackedCells *cells) {
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *row = firstRow + (ptrdiff_t)y * stride;
+		for (int x = 0; x < width; ++x) {
+			GLboolean isAlive = isBitmap ? (row[x / 8] >> (7 - x % 8)) & 1 : row[x] <= threshold;
+			if (isAlive)
+				cells->columns[(size_t)(y / 32) * (size_t)cells->columnsX + (size_t)x] |= 1u << (y % 32);
+		}
+	}
+}
+
+/* packs random images of awkward sizes both ways, returns false if they ever differ */
+GLboolean checkRowPacking(void) {
+	const int sizes[][2] = { { 1, 1 }, { 31, 33 }, { 32, 32 }, { 100, 7 }, { 1000, 777 }, { 2049, 65 } };
+	uint32_t random = 12345;
+	for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); ++i) {
+		for (int isBitmap = 0; isBitmap < 2; ++isBitmap) {
+			int width = sizes[i][0];
+			int height = sizes[i][1];
+			size_t rowSize = isBitmap ? ((size_t)width + 7) / 8 : (size_t)width;
+			uint8_t *pixels = (uint8_t *)malloc(rowSize * (size_t)height);
+			PackedCells fast, slow;
+			if (!pixels || !allocPackedCells(&fast, width, height) || !allocPackedCells(&slow, width, height))
+				return GL_FALSE;
+			for (size_t j = 0; j < rowSize * (size_t)height; ++j) {
+				random = random * 1664525u + 1013904223u;
+				pixels[j] = (uint8_t)(random >> 24);
+			}
+			/* bottom up, like every image that gets loaded */
+			const uint8_t *lastRow = pixels + (size_t)(height - 1) * rowSize;
+			packRows(lastRow, -(ptrdiff_t)rowSize, width, height, 127, (GLboolean)isBitmap, &fast);
+			packRowsSlowly(lastRow, -(ptrdiff_t)rowSize, width, height, 127, (GLboolean)isBitmap, &slow);
+			GLboolean isSame = memcmp(fast.columns, slow.columns, (size_t)fast.columnsX * (size_t)fast.columnsY * sizeof(uint32_t)) == 0;
+			free(pixels);
+			freePackedCells(&fast);
+			freePackedCells(&slow);
+			if (!isSame)
+				return GL_FALSE;
+		}
+	}
+	return GL_TRUE;
+}
+
+/* compresses soups of a few densities in bands and unpacks them again, returns false if they
+   ever come back different. the bands are small so that there are many of them, and the last
+   one is shorter than the rest */
+GLboolean checkSnapshotCodec(void) {
+	const double densities[] = { 0.0, 0.02, 0.5, 1.0 };
+	for (int i = 0; i < (int)(sizeof(densities) / sizeof(densities[0])); ++i) {
+		WorldSpec spec = { WORLD_SOUP, 1000, 777, densities[i], (uint64_t)i + 1 };
+		PackedCells source, unpacked;
+		if (!generateWorld(&spec, &source))
+			return GL_FALSE;
+		if (!allocPackedCells(&unpacked, source.width, source.height)) {
+			freePackedCells(&source);
+			return GL_FALSE;
+		}
+
+		SnapshotCodec codec;
+		initSnapshotCodec(&codec, source.columns, source.columnsX, source.columnsY * 32, 3);
+		int numBands = getNumSnapshotBands(&codec);
+		codec.bands = (SnapshotBand *)calloc((size_t)numBands, sizeof(SnapshotBand));
+		codec.compressed = (uint8_t **)calloc((size_t)numBands, sizeof(uint8_t *));
+		if (codec.bands && codec.compressed)
+			parallelFor(numBands, compressSnapshotBand, &codec);
+		else
+			codec.isOk = 0;
+		/* the same bands unpack into the other cells */
+		codec.columns = unpacked.columns;
+		codec.compressedBands = (const uint8_t **)codec.compressed;
+		if (codec.isOk)
+			parallelFor(numBands, decompressSnapshotBand, &codec);
+		GLboolean isSame = codec.isOk && memcmp(source.columns, unpacked.columns,
+			(size_t)source.columnsX * (size_t)source.columnsY * sizeof(uint32_t)) == 0;
+
+		for (int j = 0; codec.compressed && j < numBands; ++j)
+			free(codec.compressed[j]);
+		free(codec.compressed);
+		free(codec.bands);
+		freePackedCells(&source);
+		freePackedCells(&unpacked);
+		if (!isSame)
+			return GL_FALSE;
+	}
+	return GL_TRUE;
+}
+
+/* writes a soup out as RLE and decodes it again, returns false if any word comes back different.
+   cells in two opposite corners keep the cropped pattern the same size as the world, and a
+   stretch of empty bands in the middle has to be skipped over in one go */
+GLboolean checkRleWriter(void) {
+	WorldSpec spec = { WORLD_SOUP, 1000, 777, 0.3, 1 };
+	PackedCells source, parsed;
+	if (!generateWorld(&spec, &source))
+		return GL_FALSE;
+	size_t numWords = (size_t)source.columnsX * (size_t)source.columnsY;
+	memset(&source.columns[(size_t)7 * (size_t)source.columnsX], 0, (size_t)6 * (size_t)source.columnsX * sizeof(uint32_t));
+	source.columns[0] |= 1;
+	source.columns[numWords - 1] |= 1u << 31;
+
+	char path[512];
+	makeDirectory(CACHE_DIRECTORY);
+	snprintf(path, sizeof(path), "%s/rle-self-check.rle", CACHE_DIRECTORY);
+	FILE *f = fopen(path, "wb");
+	GLboolean isOk = f && writeRle(f, source.columns, source.columnsX, source.columnsY * 32, 0);
+	if (f)
+		isOk &= fclose(f) == 0;
+
+	MappedFile file;
+	isOk = isOk && mapFile(&file, path);
+	GLboolean isSame = GL_FALSE;
+	if (isOk) {
+		const char *end = file.data + file.size;
+		const char *header = file.data;
+		while (header < end && *header == '#') {
+			while (header < end && *header != '\n')
+				++header;
+			++header;
+		}
+		int width, height;
+		if (header < end && 2 == sscanf(header, " x = %d , y = %d ", &width, &height) &&
+			width == source.columnsX && height == source.columnsY * 32 && allocPackedCells(&parsed, width, height)) {
+			RleDecoder decoder;
+			initRleDecoder(&decoder, &parsed, NULL, height);
+			isSame = decodeRleParallel(&decoder, findRleBody(file.data, end), end) && decoder.isValid &&
+				memcmp(source.columns, parsed.columns, numWords * sizeof(uint32_t)) == 0;
+			freePackedCells(&parsed);
+		}
+		unmapFile(&file);
+	}
+	remove(path);
+	freePackedCells(&source);
+	return isSame;
+}
+
+/* a glider gzipped once as a stored block, and once as a fixed huffman block that has matches */
+const char inflateCheckText[] = "#N glider\nx = 3, y = 3, rule = B3/S23\nbo$2bo$3o!\n";
+
+const uint8_t inflateCheckStored[] = {
+	0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x03, 0x01, 0x31, 0x00, 0xCE, 0xFF, 0x23,
+	0x4E, 0x20, 0x67, 0x6C, 0x69, 0x64, 0x65, 0x72, 0x0A, 0x78, 0x20, 0x3D, 0x20, 0x33, 0x2C, 0x20,
+	0x79, 0x20, 0x3D, 0x20, 0x33, 0x2C, 0x20, 0x72, 0x75, 0x6C, 0x65, 0x20, 0x3D, 0x20, 0x42, 0x33,
+	0x2F, 0x53, 0x32, 0x33, 0x0A, 0x62, 0x6F, 0x24, 0x32, 0x62, 0x6F, 0x24, 0x33, 0x6F, 0x21, 0x0A,
+	0xAF, 0x01, 0x5D, 0x69, 0x31, 0x00, 0x00, 0x00 };
+
+const uint8_t inflateCheckFixed[] = {
+	0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x53, 0xF6, 0x53, 0x48, 0xCF, 0xC9,
+	0x4C, 0x49, 0x2D, 0xE2, 0xAA, 0x50, 0xB0, 0x55, 0x30, 0xD6, 0x51, 0xA8, 0x84, 0x50, 0x45, 0xA5,
+	0x39, 0xA9, 0x40, 0x96, 0x93, 0xB1, 0x7E, 0xB0, 0x91, 0x31, 0x57, 0x52, 0xBE, 0x8A, 0x11, 0x10,
+	0x1B, 0xE7, 0x2B, 0x72, 0x01, 0x00, 0xAF, 0x01, 0x5D, 0x69, 0x31, 0x00, 0x00, 0x00 };
+
+/* inflates both files the way a stream does, all at once and then a few bytes at a time so that
+   stored runs and matches get split, returns false if the text or the end of the member is wrong */
+GLboolean checkInflater(void) {
+	const uint8_t *members[2] = { inflateCheckStored, inflateCheckFixed };
+	size_t memberSizes[2] = { sizeof(inflateCheckStored), sizeof(inflateCheckFixed) };
+	size_t textSize = sizeof(inflateCheckText) - 1;
+	Inflater *inf = (Inflater *)malloc(sizeof(Inflater));
+	if (!inf)
+		return GL_FALSE;
+
+	char path[512];
+	makeDirectory(CACHE_DIRECTORY);
+	snprintf(path, sizeof(path), "%s/inflate-self-check.gz", CACHE_DIRECTORY);
+	GLboolean isOk = GL_TRUE;
+	for (int i = 0; i < 4 && isOk; ++i) {
+		FILE *f = fopen(path, "wb");
+		isOk = f && fwrite(members[i / 2], 1, memberSizes[i / 2], f) == memberSizes[i / 2];
+		if (f)
+			isOk &= fclose(f) == 0;
+		f = isOk ? fopen(path, "rb") : NULL;
+		if (!f) {
+			isOk = GL_FALSE;
+			break;
+		}
+
+		/* the magic has already been read by the time a stream hands the file over */
+		uint8_t magic[2];
+		size_t magicSize = fread(magic, 1, sizeof(magic), f);
+		initInflater(inf, f, magic, magicSize);
+		uint8_t text[64];
+		size_t pieceSize = i % 2 ? 5 : sizeof(text);
+		size_t numInflated = 0;
+		for (;;) {
+			size_t left = sizeof(text) - numInflated;
+			size_t size = inflateGzip(inf, &text[numInflated], left < pieceSize ? left : pieceSize);
+			if (size == 0)
+				break;
+			numInflated += size;
+		}
+		isOk = inf->state == INFLATE_DONE && numInflated == textSize && memcmp(text, inflateCheckText, textSize) == 0;
+		fclose(f);
+	}
+	remove(path);
+	free(inf);
+	return isOk;
+}
+
+/* checks of the fast paths against something simpler, or of encoders against their decoders.
+   they run before every benchmark, and a failing one fails the run */
+typedef struct SelfCheck {
+	const char *name;
+	GLboolean (*check)(void);
+} SelfCheck;
+
+const SelfCheck selfChecks[] = {
+	{ "row packing", checkRowPacking },
+	{ "snapshot codec", checkSnapshotCodec },
+	{ "rle writer", checkRleWriter },
+	{ "gzip inflater", checkInflater },
+};
+#endif
+
+/* reads the whitespace separated numbers of a netpbm header, along with any comments */
+GLboolean parsePnmHeader(const char **text, const char *end, int *values, int count) {
+	const char *p = *text;
+	for (int i = 0; i < count; ++i) {
+		for (;;) {
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+				++p;
+			if (p == end || *p != '#')
+				break;
+			while (p < end && *p != '\n')
+				++p;
+		}
+		int64_t value = 0;
+		if (p == end || *p < '0' || *p > '9')
+			return GL_FALSE;
+		while (p < end && *p >= '0' && *p <= '9' && value <= INT32_MAX)
+			value = 10 * value + (*p++ - '0');
+		if (value > INT32_MAX)
+			return GL_FALSE;
+		values[i] = (int)value;
+	}
+	/* exactly one whitespace character separates the header from the pixels */
+	if (p == end)
+		return GL_FALSE;
+	*text = p + 1;
+	return GL_TRUE;
+}
+
+/* every pattern format has a sniff function that looks at the start of the file, and a reader
+   that takes it from there. formats are tried in order, so looser sniffs go further down. only
+   the RLE reader can leave decoding to the GPU, the others ignore decodeOnGpu */
+typedef struct PatternFormat {
+	const char *name;
+	GLboolean (*sniff)(const char *head, size_t size);
+	GLboolean (*read)(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu);
+} PatternFormat;
+
+GLboolean isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+const char *skipSpaces(const char *p, const char *end) {
+	while (p < end && isSpace(*p))
+		++p;
+	return p;
+}
+
+/* snapshot file (.gls) */
+GLboolean sniffSnapshot(const char *head, size_t size) {
+	return size >= 8 && memcmp(head, "GPULIFE", 8) == 0;
+}
+
+GLboolean readSnapshotPattern(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	(void)decodeOnGpu;
+	if (!stream->isMappable) {
+		printf("snapshots have to be uncompressed\n");
+		return GL_FALSE;
+	}
+	return readSnapshot(stream->path, loaded);
+}
+
+/* recording (.glr), these are opened on the main thread since all they have is an index */
+GLboolean sniffRecording(const char *head, size_t size) {
+	return size >= 6 && memcmp(head, "GLREC", 6) == 0;
+}
+
+GLboolean readRecordingPattern(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	(void)decodeOnGpu;
+	if (!stream->isMappable) {
+		printf("recordings have to be uncompressed\n");
+		return GL_FALSE;
+	}
+	loaded->kind = LOADED_RECORDING;
+	return GL_TRUE;
+}
+
+/* macrocell file (.mc) */
+GLboolean sniffMacrocell(const char *head, size_t size) {
+	return size >= 4 && memcmp(head, "[M2]", 4) == 0;
+}
+
+GLboolean readMacrocellPattern(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	(void)decodeOnGpu;
+	Macrocell macrocell;
+	GLboolean isOk = parseMacrocell(stream, &macrocell, &loaded->generation);
+	if (isOk)
+		isOk = expandMacrocell(&macrocell, &loaded->cells);
+	free(macrocell.nodes);
+	if (!isOk) {
+		printf("invalid macrocell file\n");
+		return GL_FALSE;
+	}
+	loaded->kind = LOADED_CELLS;
+	return GL_TRUE;
+}
+
+/* binary PBM (P4) and 8-bit PGM (P5) images are packed straight out of a memory mapping.
+   anything else netpbm is left to stb_image */
+GLboolean sniffPnm(const char *head, size_t size) {
+	if (size < 3 || head[0] != 'P' || (head[1] != '4' && head[1] != '5') || !isSpace(head[2]))
+		return GL_FALSE;
+	const char *p = head + 2;
+	int header[3] = { 0, 0, 1 };
+	return parsePnmHeader(&p, head + size, header, head[1] == '4' ? 2 : 3) && header[2] >= 1 && header[2] <= 255;
+}
+
+GLboolean readPnm(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	(void)decodeOnGpu;
+	size_t size;
+	const char *data = getStreamContents(stream, &size);
+	if (!data) {
+		printf("out of memory\n");
+		return GL_FALSE;
+	}
+	const char *p = data + 2;
+	const char *end = data + size;
+	GLboolean isBitmap = data[1] == '4';
+	int header[3] = { 0, 0, 1 };
+	if (!parsePnmHeader(&p, end, header, isBitmap ? 2 : 3) || header[2] < 1 || header[2] > 255) {
+		printf("invalid image file\n");
+		return GL_FALSE;
+	}
+
+	int width = header[0];
+	int height = header[1];
+	size_t rowSize = isBitmap ? ((size_t)width + 7) / 8 : (size_t)width;
+	if (width < 1 || height < 1 || (size_t)(end - p) / rowSize < (size_t)height) {
+		printf("invalid image file\n");
+		return GL_FALSE;
+	}
+	if (width > maxTextureSize || height > maxTextureSize) {
+		printf("%d x %d texture is larger than the maximum %d x %d\n",
+			width, height, maxTextureSize, maxTextureSize);
+		return GL_FALSE;
+	}
+	if (!allocPackedCells(&loaded->cells, width, height)) {
+		printf("out of memory\n");
+		return GL_FALSE;
+	}
+
+	/* the files go top down and the world goes bottom up */
+	const uint8_t *lastRow = (const uint8_t *)p + (size_t)(height - 1) * rowSize;
+	packRows(lastRow, -(ptrdiff_t)rowSize, width, height, (uint8_t)(127 * header[2] / 255), isBitmap, &loaded->cells);
+	loaded->kind = LOADED_CELLS;
+	return GL_TRUE;
+}
+
+/* life 1.06 file (.life) */
+GLboolean sniffLife(const char *head, size_t size) {
+	const char *p = skipSpaces(head, head + size);
+	return (size_t)(head + size - p) > 10 && memcmp(p, "#Life 1.06", 10) == 0;
+}
+
+GLboolean readLife(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	(void)decodeOnGpu;
+	/* the whole file is read exactly once, straight out of a memory mapping if we can */
+	size_t size;
+	const char *start = getStreamContents(stream, &size);
+	if (!start) {
+		printf("out of memory\n");
+		return GL_FALSE;
+	}
+	const char *end = start + size;
+
+	/* skip the "#Life 1.06" line, any other comments are skipped along with the coordinates */
+	start = skipSpaces(start, end);
+	while (start < end && *start != '\n')
+		++start;
+
+	CellCoordinates coordinates;
+	if (!parseLifeCoordinates(start, end, &coordinates))
+		return GL_FALSE;
+
+	int64_t lifeWidth = 1 + (int64_t)coordinates.maxX - coordinates.minX;
+	int64_t lifeHeight = 1 + (int64_t)coordinates.maxY - coordinates.minY;
+	if (lifeWidth > maxTextureSize || lifeHeight > maxTextureSize) {
+		printf("%lld x %lld texture is larger than the maximum %d x %d\n",
+			(long long)lifeWidth, (long long)lifeHeight, maxTextureSize, maxTextureSize);
+		free(coordinates.xy);
+		return GL_FALSE;
+	}
+
+	if (!allocPackedCells(&loaded->cells, (int)lifeWidth, (int)lifeHeight)) {
+		printf("out of memory\n");
+		free(coordinates.xy);
+		return GL_FALSE;
+	}
+	scatterCellCoordinates(&coordinates, &loaded->cells);
+	free(coordinates.xy);
+	loaded->kind = LOADED_CELLS;
+	return GL_TRUE;
+}
+
+/* RLE life file (.rle). comment lines can go on for longer than the head, in which case
+   the header line is taken on trust */
+GLboolean sniffRle(const char *head, size_t size) {
+	const char *p = head;
+	const char *end = head + size;
+	for (;;) {
+		p = skipSpaces(p, end);
+		if (p == end)
+			return GL_TRUE;
+		if (*p != '#')
+			break;
+		while (p < end && *p != '\n')
+			++p;
+	}
+	if (*p != 'x')
+		return GL_FALSE;
+	p = skipSpaces(p + 1, end);
+	return p == end || *p == '=';
+}
+
+GLboolean readRlePattern(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	char line[1024];
+	int width, height;
+	GLboolean isLine;
+	do {
+		isLine = readStreamLine(stream, line, sizeof(line));
+	} while (isLine && line[0] == '#');
+	if (!isLine || 2 != sscanf(line, " x = %d , y = %d ", &width, &height) || width < 1 || height < 1) {
+		printf("invalid rle file\n");
+		return GL_FALSE;
+	}
+
+	if (width > maxTextureSize || height > maxTextureSize) {
+		printf("%d x %d texture is larger than the maximum %d x %d\n", 
+			width, height, maxTextureSize, maxTextureSize);
+		return GL_FALSE;
+	}
+
+	/* the pattern is never expanded into a byte per cell, runs are packed straight
+	   into column words or collected into a run list for the GPU to rasterize */
+	PackedCells *cells = &loaded->cells;
+	CellRuns *runs = &loaded->runs;
+	runs->width = width;
+	runs->height = height;
+	if (!decodeOnGpu && !allocPackedCells(cells, width, height)) {
+		printf("out of memory\n");
+		return GL_FALSE;
+	}
+
+	/* mapped files are decoded in parallel, compressed ones stream through a block at a time */
+	RleDecoder decoder;
+	initRleDecoder(&decoder, decodeOnGpu ? NULL : cells, runs, height);
+	size_t size;
+	const char *body = decodeOnGpu || !stream->isMappable ? NULL : getStreamContents(stream, &size);
+	if (body) {
+		decoder.isOk = decodeRleParallel(&decoder, body, body + size);
+	} else {
+		const char *start, *end;
+		while (!decoder.isDone && readStreamBlock(stream, &start, &end))
+			decodeRle(&decoder, start, end);
+	}
+
+	if (!decoder.isValid || !decoder.isOk) {
+		printf(decoder.isValid ? "out of memory\n" : "invalid rle file\n");
+		freePackedCells(cells);
+		free(runs->runs);
+		return GL_FALSE;
+	}
+
+	loaded->kind = decodeOnGpu ? LOADED_RUNS : LOADED_CELLS;
+	loaded->width = width;
+	loaded->height = height;
+	return GL_TRUE;
+}
+
+/* apgcodes as used by catagolue, like xs4_33 for a block. the code after the underscore is
+   in extended wechsler format: every character is a column of 5 cells going down, with bit 0
+   at the top, 'w' and 'x' are 2 and 3 empty columns, 'y' and a character after it are 4 or
+   more, and 'z' starts the next strip of 5 rows */
+GLboolean sniffApgcode(const char *head, size_t size) {
+	const char *end = head + size;
+	const char *p = skipSpaces(head, end);
+	if (end - p < 4 || p[0] != 'x' || (p[1] != 's' && p[1] != 'p' && p[1] != 'q'))
+		return GL_FALSE;
+	p += 2;
+	const char *digits = p;
+	while (p < end && *p >= '0' && *p <= '9')
+		++p;
+	return p > digits && p < end && *p == '_';
+}
+
+int getWechslerValue(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'z')
+		return c - 'a' + 10;
+	return -1;
+}
+
+/* goes over the code once to measure it, and once more to set the cells */
+GLboolean decodeWechsler(const char *p, const char *end, int *width, int *height, PackedCells *cells) {
+	int x = 0, strip = 0;
+	for (; p < end && !isSpace(*p); ++p) {
+		char c = *p;
+		int value = getWechslerValue(c);
+		if (c == 'w') {
+			x += 2;
+		} else if (c == 'x') {
+			x += 3;
+		} else if (c == 'y') {
+			if (p + 1 == end || getWechslerValue(p[1]) < 0)
+				return GL_FALSE;
+			x += 4 + getWechslerValue(*++p);
+		} else if (c == 'z') {
+			++strip;
+			x = 0;
+		} else if (value >= 0 && value < 32) {
+			for (int i = 0; i < 5; ++i) {
+				if (!(value & (1 << i)))
+					continue;
+				int y = 5 * strip + i;
+				if (cells)
+					setPackedRun(cells, cells->height - 1 - y, x, 1);
+				if (x + 1 > *width)
+					*width = x + 1;
+				if (y + 1 > *height)
+					*height = y + 1;
+			}
+			++x;
+		} else {
+			return GL_FALSE;
+		}
+		if (x > maxTextureSize || 5 * strip > maxTextureSize)
+			return GL_FALSE;
+	}
+	return GL_TRUE;
+}
+
+GLboolean readApgcode(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	(void)decodeOnGpu;
+	size_t size;
+	const char *start = getStreamContents(stream, &size);
+	if (!start) {
+		printf("out of memory\n");
+		return GL_FALSE;
+	}
+	const char *end = start + size;
+	const char *code = skipSpaces(start, end);
+	while (code < end && *code != '_')
+		++code;
+	++code;
+
+	int width = 0, height = 0;
+	if (!decodeWechsler(code, end, &width, &height, NULL) || width == 0) {
+		printf("invalid apgcode\n");
+		return GL_FALSE;
+	}
+	if (!allocPackedCells(&loaded->cells, width, height)) {
+		printf("out of memory\n");
+		return GL_FALSE;
+	}
+	decodeWechsler(code, end, &width, &height, &loaded->cells);
+	loaded->kind = LOADED_CELLS;
+	return GL_TRUE;
+}
+
+/* plaintext file (.cells), rows of '.' and 'O' top down with '!' comment lines */
+GLboolean sniffPlaintext(const char *head, size_t size) {
+	const char *end = head + size;
+	if (size > 0 && head[0] == '!')
+		return GL_TRUE;
+	const char *p = head;
+	while (p < end && (*p == '.' || *p == 'O' || *p == '*'))
+		++p;
+	return p > head && (p == end || *p == '\r' || *p == '\n');
+}
+
+/* goes over the rows once to measure them, and once more to set the cells */
+void decodePlaintext(const char *p, const char *end, int *width, int *height, PackedCells *cells) {
+	int y = 0;
+	while (p < end) {
+		const char *line = p;
+		while (p < end && *p != '\n')
+			++p;
+		const char *lineEnd = p;
+		if (p < end)
+			++p;
+		if (*line == '!')
+			continue;
+		if (lineEnd > line && lineEnd[-1] == '\r')
+			--lineEnd;
+
+		int x = 0;
+		const char *c = line;
+		while (c < lineEnd) {
+			if (*c != 'O' && *c != '*') {
+				++c;
+				++x;
+				continue;
+			}
+			const char *run = c;
+			while (c < lineEnd && (*c == 'O' || *c == '*'))
+				++c;
+			if (cells)
+				setPackedRun(cells, cells->height - 1 - y, x, (int)(c - run));
+			x += (int)(c - run);
+		}
+		if (x > *width)
+			*width = x;
+		++y;
+	}
+	*height = y;
+}
+
+GLboolean readPlaintext(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	(void)decodeOnGpu;
+	size_t size;
+	const char *start = getStreamContents(stream, &size);
+	if (!start) {
+		printf("out of memory\n");
+		return GL_FALSE;
+	}
+
+	int width = 0, height = 0;
+	decodePlaintext(start, start + size, &width, &height, NULL);
+	if (width == 0 || height == 0) {
+		printf("invalid plaintext file\n");
+		return GL_FALSE;
+	}
+	if (width > maxTextureSize || height > maxTextureSize) {
+		printf("%d x %d texture is larger than the maximum %d x %d\n", 
+			width, height, maxTextureSize, maxTextureSize);
+		return GL_FALSE;
+	}
+	if (!allocPackedCells(&loaded->cells, width, height)) {
+		printf("out of memory\n");
+		return GL_FALSE;
+	}
+	decodePlaintext(start, start + size, &width, &height, &loaded->cells);
+	loaded->kind = LOADED_CELLS;
+	return GL_TRUE;
+}
+
+/* image file, anything stb_image can make sense of */
+GLboolean sniffImage(const char *head, size_t size) {
+	int width, height, comp;
+	return size > 0 && stbi_info_from_memory((const stbi_uc *)head, (int)size, &width, &height, &comp);
+}
+
+GLboolean readImage(Stream *stream, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	(void)decodeOnGpu;
+	size_t size;
+	const char *data = getStreamContents(stream, &size);
+	if (!data || size > INT32_MAX) {
+		printf("couldnt read %s\n", stream->path);
+		return GL_FALSE;
+	}
+
+	int width, height, comp;
+	if (!stbi_info_from_memory((const stbi_uc *)data, (int)size, &width, &height, &comp)) {
+		printf("couldnt load %s: %s\n", stream->path, stbi_failure_reason());
+		return GL_FALSE;
+	}
+	if (width > maxTextureSize || height > maxTextureSize) {
+		printf("%d x %d texture is larger than the maximum %d x %d\n", 
+			width, height, maxTextureSize, maxTextureSize);
+		return GL_FALSE;
+	}
+
+	/* the image isn't flipped on load, packing it bottom up is free */
+	stbi_set_flip_vertically_on_load(0);
+	stbi_uc *pixels = stbi_load_from_memory((const stbi_uc *)data, (int)size, &width, &height, &comp, STBI_grey);
+	if (!pixels) {
+		printf("couldnt load %s: %s\n", stream->path, stbi_failure_reason());
+		return GL_FALSE;
+	}
+
+	if (!allocPackedCells(&loaded->cells, width, height)) {
+		printf("out of memory\n");
+		stbi_image_free(pixels);
+		return GL_FALSE;
+	}
+	const stbi_uc *lastRow = pixels + (size_t)(height - 1) * (size_t)width;
+	packRows(lastRow, -(ptrdiff_t)width, width, height, 127, GL_FALSE, &loaded->cells);
+	stbi_image_free(pixels);
+	loaded->kind = LOADED_CELLS;
+	return GL_TRUE;
+}
+
+const PatternFormat patternFormats[] = {
+	{ "snapshot", sniffSnapshot, readSnapshotPattern },
+	{ "recording", sniffRecording, readRecordingPattern },
+	{ "macrocell", sniffMacrocell, readMacrocellPattern },
+	{ "netpbm", sniffPnm, readPnm },
+	{ "life 1.06", sniffLife, readLife },
+	{ "apgcode", sniffApgcode, readApgcode },
+	{ "plaintext", sniffPlaintext, readPlaintext },
+	{ "rle", sniffRle, readRlePattern },
+	{ "image", sniffImage, readImage },
+};
+
+/* reads a pattern file into a form that can be uploaded in one go. this runs on its own thread
+   so it must not touch OpenGL, everything that does is left to finishPatternLoad */
+GLboolean parsePattern(const char *file, LoadedPattern *loaded, GLboolean decodeOnGpu) {
+	Stream stream;
+	if (!openStream(&stream, file)) {
+		printf("couldnt open %s\n", file);
+		return GL_FALSE;
+	}
+
+	for (size_t i = 0; i < sizeof(patternFormats) / sizeof(patternFormats[0]); ++i) {
+		const PatternFormat *format = &patternFormats[i];
+		if (format->sniff(stream.buffer, stream.size)) {
+			printf("loading %s .. ", file);
+			GLboolean isOk = format->read(&stream, loaded, decodeOnGpu);
+			if (isOk && isStreamBroken(&stream)) {
+				printf("corrupted gzip data\n");
+				freePackedCells(&loaded->cells);
+				free(loaded->runs.runs);
+				isOk = GL_FALSE;
+			}
+			closeStream(&stream);
+			return isOk;
+		}
+	}
+
+	closeStream(&stream);
+	printf("unknown file format %s\n", file);
+	return GL_FALSE;
+}
+
+/* the key of a pattern file in the cache is a hash of its contents. snapshots and recordings
+   already load without parsing, and small files parse faster than the cache can be checked */
+GLboolean hashPatternFile(const char *file, uint64_t *key) {
+	MappedFile mapped;
+	if (!mapFile(&mapped, file))
+		return GL_FALSE;
+	GLboolean isCacheable = mapped.size >= CACHE_MIN_FILE_SIZE &&
+		memcmp(mapped.data, "GPULIFE", 8) != 0 &&
+		memcmp(mapped.data, "GLREC", 6) != 0;
+	if (isCacheable)
+		*key = hash64(mapped.data, mapped.size, SNAPSHOT_VERSION);
+	unmapFile(&mapped);
+	return isCacheable;
+}
+
+void getCachePath(char *path, size_t size, uint64_t key) {
+	snprintf(path, size, "%s/%016llx.gls", CACHE_DIRECTORY, (unsigned long long)key);
+}
+
+/* reads or writes a block of cell columns that can wrap around the edges of the world, as up
+   to 4 pieces. block holds numRows rows of width columns starting at column x of row firstRow */
+void transferCellBlock(uint32_t *block, int x, int firstRow, int width, int numRows, GLboolean isWrite) {
+	int worldRows = numCellsY / 32;
+	if (isWrite) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glBindTexture(GL_TEXTURE_2D, cellsRead);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+	} else {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, cellsReadFramebuffer);
+		glPixelStorei(GL_PACK_ROW_LENGTH, width);
+	}
+	for (int i = 0; i < 4; ++i) {
+		int pieceX = (i & 1) ? numCellsX - x : 0;
+		int pieceRow = (i & 2) ? worldRows - firstRow : 0;
+		int pieceWidth = (i & 1) ? width - pieceX : (width < numCellsX - x ? width : numCellsX - x);
+		int pieceRows = (i & 2) ? numRows - pieceRow : (numRows < worldRows - firstRow ? numRows : worldRows - firstRow);
+		if (pieceWidth <= 0 || pieceRows <= 0)
+			continue;
+		uint32_t *piece = block + (size_t)pieceRow * width + pieceX;
+		int toX = (x + pieceX) % numCellsX;
+		int toRow = (firstRow + pieceRow) % worldRows;
+		if (isWrite)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, toX, toRow, pieceWidth, pieceRows, GL_RED_INTEGER, GL_UNSIGNED_INT, piece);
+		else
+			glReadPixels(toX, toRow, pieceWidth, pieceRows, GL_RED_INTEGER, GL_UNSIGNED_INT, piece);
+	}
+	glPixelStorei(isWrite ? GL_UNPACK_ROW_LENGTH : GL_PACK_ROW_LENGTH, 0);
+	glCheckErrors();
+}
+
+/* the rows of a pattern that land in pattern column word k, as a mask */
+uint32_t getPasteMask(int k, int height) {
+	if (k < 0 || 32 * k >= height)
+		return 0;
+	return height - 32 * k >= 32 ? ~0u : (1u << (height - 32 * k)) - 1;
+}
+
+/* pastes cells into the world centered on a cell, leaving everything else alone. only the
+   band of column words that the pattern covers is read back, combined and uploaded again */
+void pastePackedCells(const PackedCells *pattern, int centerX, int centerY, PasteMode mode) {
+	int width = pattern->width < numCellsX ? pattern->width : numCellsX;
+	int height = pattern->height < numCellsY ? pattern->height : numCellsY;
+	int x = ((centerX - width / 2) % numCellsX + numCellsX) % numCellsX;
+	int y = ((centerY - height / 2) % numCellsY + numCellsY) % numCellsY;
+	int shift = y % 32;
+	int firstRow = y / 32;
+	int numRows = (shift + height + 31) / 32;
+	/* the top and bottom words of a pattern as tall as the world would be the same word */
+	if (numRows > numCellsY / 32) {
+		numRows = numCellsY / 32;
+		height = 32 * numRows - shift;
+	}
+
+	uint32_t *block = (uint32_t *)malloc((size_t)width * numRows * sizeof(uint32_t));
+	if (!block) {
+		printf("out of memory\n");
+		return;
+	}
+	transferCellBlock(block, x, firstRow, width, numRows, GL_FALSE);
+
+	/* pattern word k covers rows 32k .. 32k+31 of the pattern, which go up by the shift
+	   and land partly in block row k and partly in block row k+1 */
+	for (int row = 0; row < numRows; ++row) {
+		const uint32_t *hi = row < pattern->columnsY ? pattern->columns + (size_t)row * pattern->columnsX : NULL;
+		const uint32_t *lo = row > 0 && row - 1 < pattern->columnsY ? pattern->columns + (size_t)(row - 1) * pattern->columnsX : NULL;
+		uint32_t maskHi = getPasteMask(row, height);
+		uint32_t maskLo = getPasteMask(row - 1, height);
+		uint32_t mask = shift ? (maskHi << shift) | (maskLo >> (32 - shift)) : maskHi;
+		uint32_t *words = block + (size_t)row * width;
+		for (int i = 0; i < width; ++i) {
+			uint32_t wordHi = hi ? hi[i] & maskHi : 0;
+			uint32_t wordLo = lo ? lo[i] & maskLo : 0;
+			uint32_t bits = shift ? (wordHi << shift) | (wordLo >> (32 - shift)) : wordHi;
+			if (mode == PASTE_COPY)
+				words[i] = (words[i] & ~mask) | bits;
+			else if (mode == PASTE_OR)
+				words[i] |= bits;
+			else
+				words[i] ^= bits;
+		}
+	}
+
+	transferCellBlock(block, x, firstRow, width, numRows, GL_TRUE);
+	free(block);
+}
+
+/* patterns are loaded on a separate thread so that the current one keeps running in the
+   meantime, the main loop swaps the new one in once it's ready, or pastes it into the world */
+typedef struct PatternLoad {
+	GLboolean isLoading;
+	char file[512];
+	GLboolean decodeOnGpu;
+	GLboolean isPaste;
+	int pasteX;
+	int pasteY;
+	Thread worker;
+	volatile int isDone;
+	GLboolean isOk;
+	GLboolean isCacheable;
+	GLboolean isCached;
+	uint64_t key;
+	LoadedPattern loaded;
+} PatternLoad;
+
+PatternLoad patternLoad;
+
+void runPatternLoad(void *arg) {
+	PatternLoad *load = (PatternLoad *)arg;
+	const char *file = load->file;
+	load->isCached = GL_FALSE;
+	/* cached patterns are padded out to whole column words, pastes want the exact size */
+	load->isCacheable = !load->isPaste && hashPatternFile(file, &load->key);
+	if (load->isCacheable) {
+		char cachePath[512];
+		getCachePath(cachePath, sizeof(cachePath), load->key);
+		FILE *cached = fopen(cachePath, "rb");
+		if (cached) {
+			fclose(cached);
+			printf("loading %s from cache .. ", file);
+			/* a broken cache entry just gets parsed and written again */
+			load->isCached = readSnapshot(cachePath, &load->loaded);
+		}
+	}
+	load->isOk = load->isCached || parsePattern(file, &load->loaded, load->decodeOnGpu);
+	atomicFetchAdd(&load->isDone, 1);
+}
+
+void pasteLoadedPattern(PatternLoad *load) {
+	LoadedPattern *loaded = &load->loaded;
+	PackedCells snapshotCells;
+	switch (loaded->kind) {
+		case LOADED_CELLS:
+			pastePackedCells(&loaded->cells, load->pasteX, load->pasteY, pasteMode);
+			freePackedCells(&loaded->cells);
+			break;
+		case LOADED_SNAPSHOT:
+			snapshotCells.width = snapshotCells.columnsX = ((const SnapshotHeader *)loaded->snapshot.data)->width;
+			snapshotCells.height = ((const SnapshotHeader *)loaded->snapshot.data)->height;
+			snapshotCells.columnsY = snapshotCells.height / 32;
+			snapshotCells.columns = (uint32_t *)(loaded->snapshot.data + sizeof(SnapshotHeader));
+			pastePackedCells(&snapshotCells, load->pasteX, load->pasteY, pasteMode);
+			unmapFile(&loaded->snapshot);
+			break;
+		case LOADED_RUNS:
+			free(loaded->runs.runs);
+			/* fall through */
+		case LOADED_RECORDING:
+			printf("only patterns can be pasted\n");
+			return;
+	}
+	printf("pasted at %d, %d\n", load->pasteX, load->pasteY);
+}
+
+void finishPatternLoad(PatternLoad *load) {
+	LoadedPattern *loaded = &load->loaded;
+	if (load->isPaste) {
+		pasteLoadedPattern(load);
+		return;
+	}
+
+	/* recordings only make sense for a single world */
+	stopRecording();
+	closeRecording();
+
+	switch (loaded->kind) {
+		case LOADED_CELLS:
+			setPackedCells(&loaded->cells);
+			freePackedCells(&loaded->cells);
+			break;
+		case LOADED_RUNS:
+			setCellRuns(&loaded->runs, loaded->width, loaded->height);
+			free(loaded->runs.runs);
+			break;
+		case LOADED_SNAPSHOT:
+			uploadSnapshot(&loaded->snapshot);
+			unmapFile(&loaded->snapshot);
+			break;
+		case LOADED_RECORDING:
+			if (!openRecording(load->file))
+				return;
+			setPatternName(load->file);
+			printf("done, %d generations\n", (int)playback.header->numFrames);
+			return;
+	}
+	generation = loaded->generation;
+	setPatternName(load->file);
+	printf("done\n");
+
+	if (load->isCacheable && !load->isCached) {
+		char cachePath[512];
+		getCachePath(cachePath, sizeof(cachePath), load->key);
+		makeDirectory(CACHE_DIRECTORY);
+		if (beginSave(cachePath, writeSnapshot))
+			snapshotSave.isCompressed = GL_FALSE;
+	}
+}
+
+/* called once per frame to swap in a finished load, or in a loop until it's done if wait is set */
+void pollPatternLoad(GLboolean wait) {
+	PatternLoad *load = &patternLoad;
+	if (!load->isLoading || (!wait && !atomicFetchAdd(&load->isDone, 0)))
+		return;
+	joinThread(load->worker);
+	load->isLoading = GL_FALSE;
+	loadSteps = 0;
+	if (load->isOk)
+		finishPatternLoad(load);
+}
+
+void onFileDragAndDrop(GLFWwindow *window, int numFiles, const char **files) {
+	PatternLoad *load = &patternLoad;
+	if (load->isLoading) {
+		printf("still loading %s\n", load->file);
+		return;
+	}
+
+	snprintf(load->file, sizeof(load->file), "%s", files[0]);
+	memset(&load->loaded, 0, sizeof(load->loaded));
+	/* dropping with shift held pastes the pattern where it was dropped */
+	load->isPaste =
+		glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+		glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+	getMouseCell(&load->pasteX, &load->pasteY);
+	load->decodeOnGpu = gpuDecodeIsOn && !load->isPaste;
+	load->isDone = 0;
+	loadSteps = 0;
+	loadStepsDone = 0;
+	load->isLoading = GL_TRUE;
+	if (!startThread(&load->worker, runPatternLoad, load)) {
+		runPatternLoad(load);
+		load->isLoading = GL_FALSE;
+		if (load->isOk)
+			finishPatternLoad(load);
+	}
+}
+
+#ifdef BENCHMARK
+/* every way there is of stepping the world, each benchmark pattern is run on all of them */
+typedef struct BenchmarkEngine {
+	const char *name;
+	void (*update)(void);
+} BenchmarkEngine;
+
+const BenchmarkEngine benchmarkEngines[] = {
+	{ "fragment shader", updateCells },
+};
+
+/* a world to benchmark, either a pattern file or a synthetic world spec that is made up on the spot */
+typedef struct BenchmarkPattern {
+	const char *name;
+	const char *source;
+} BenchmarkPattern;
+
+#define MAX_BENCHMARK_FILES 16
+#define MAX_BENCHMARK_REPS 100
+#define BENCHMARK_CELL_UPDATES (1ull << 38)
+
+#define BASELINE_DIRECTORY "baselines"
+#define MIN_BASELINE_REPS 3
+
+/* the times of one result in a baseline, by the name it was printed with */
+typedef struct BaselineResult {
+	char name[256];
+	int numTimes;
+	double times[MAX_BENCHMARK_REPS];
+} BaselineResult;
+
+typedef struct Benchmark {
+	const char *jsonPath;
+	const char *files[MAX_BENCHMARK_FILES];
+	int numFiles;
+	int warmups;
+	int reps;
+	int generations;
+	GLboolean loaders;
+	/* a baseline to save this run as and/or to compare it to, by default the one for this machine */
+	const char *baselinePath;
+	GLboolean saveBaseline;
+	GLboolean compare;
+	/* how much slower in percent a result has to be for certain before it counts as a regression */
+	double tolerance;
+	BaselineResult *baseline;
+	int numBaseline;
+	FILE *baselineFile;
+	int numCompared;
+	int numMissing;
+	int numRegressions;
+	int exitCode;
+} Benchmark;
+
+Benchmark benchmark = { NULL, { NULL }, 0, 1, 5, 0, GL_FALSE, NULL, GL_FALSE, GL_FALSE, 5.0 };
+
+const BenchmarkPattern benchmarkPatterns[] = {
+	{ "clock", "digital-clock.rle" },
+	{ "soup", "soup:4096x4096:0.5" },
+	{ "sparse soup", "soup:4096x4096:0.05" },
+	{ "ash", "ash:4096x4096" },
+	{ "gliders", "gliders:4096x4096:0.1" },
+	{ "oscillators", "oscillators:4096x4096" },
+	{ "odd soup", "soup:1000x777" },
+	{ "wide soup", "soup:16384x1000" },
+	{ "tall soup", "soup:1000x16384" },
+};
+
+/* puts a benchmark pattern in the world and keeps a copy of it, so every repetition starts from the same cells */
+GLboolean loadBenchmarkPattern(const BenchmarkPattern *pattern, PackedCells *start) {
+	WorldSpec spec;
+	if (parseWorldSpec(pattern->source, &spec)) {
+		if (spec.width > maxTextureSize || spec.height > maxTextureSize) {
+			printf("%s is larger than maximum %d x %d .. skipping\n", pattern->name, maxTextureSize, maxTextureSize);
+			return GL_FALSE;
+		}
+		if (!generateWorld(&spec, start)) {
+			fprintf(stderr, "ERROR: not enough memory to benchmark %s .. skipping\n", pattern->name);
+			return GL_FALSE;
+		}
+		return GL_TRUE;
+	}
+
+	const char *file = pattern->source;
+	onFileDragAndDrop(window, 1, &file);
+	pollPatternLoad(GL_TRUE);
+	pollSnapshotSave(GL_TRUE);
+	if (!patternLoad.isOk)
+		return GL_FALSE;
+	if (!allocPackedCells(start, numCellsX, numCellsY)) {
+		fprintf(stderr, "ERROR: not enough memory to benchmark %s .. skipping\n", pattern->name);
+		return GL_FALSE;
+	}
+	transferCellBlock(start->columns, 0, 0, numCellsX, numCellsY / 32, GL_FALSE);
+	return GL_TRUE;
+}
+
+int compareDoubles(const void *a, const void *b) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+typedef struct BenchmarkStats {
+	double median;
+	double mean;
+	double variance;
+	double min;
+	double max;
+} BenchmarkStats;
+
+void getBenchmarkStats(const double *times, int count, BenchmarkStats *stats) {
+	double sorted[MAX_BENCHMARK_REPS];
+	memcpy(sorted, times, (size_t)count * sizeof(double));
+	qsort(sorted, (size_t)count, sizeof(double), compareDoubles);
+	stats->median = count % 2 ? sorted[count / 2] : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+	stats->min = sorted[0];
+	stats->max = sorted[count - 1];
+	stats->mean = 0.0;
+	for (int i = 0; i < count; ++i)
+		stats->mean += times[i];
+	stats->mean /= count;
+	/* sample variance, there's no spread to speak of with a single repetition */
+	stats->variance = 0.0;
+	for (int i = 0; i < count; ++i)
+		stats->variance += (times[i] - stats->mean) * (times[i] - stats->mean);
+	stats->variance = count > 1 ? stats->variance / (count - 1) : 0.0;
+}
+
+void writeJsonString(FILE *f, const char *s) {
+	fputc('"', f);
+	for (; *s; ++s) {
+		unsigned char c = (unsigned char)*s;
+		if (c == '"' || c == '\\')
+			fprintf(f, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(f, "\\u%04x", c);
+		else
+			fputc(c, f);
+	}
+	fputc('"', f);
+}
+
+/* timings are only comparable on the same machine, which is told apart by its renderer and number
+   of cores. this turns those into something that can go in a file name */
+void getBenchmarkProfile(char *profile, size_t size) {
+	const char *renderer = (const char *)glGetString(GL_RENDERER);
+	size_t length = 0;
+	for (; renderer && *renderer && length + 1 < size && length < 96; ++renderer) {
+		char c = *renderer;
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+			profile[length++] = c;
+		else if (length > 0 && profile[length - 1] != '-')
+			profile[length++] = '-';
+	}
+	if (length > 0 && profile[length - 1] == '-')
+		--length;
+	snprintf(profile + length, size - length, "%s%d-core", length > 0 ? "-" : "", getNumCores());
+}
+
+/* a baseline is a text file with a line per result, its name, a tab and the times of every repetition */
+GLboolean readBaseline(const char *path) {
+	Benchmark *b = &benchmark;
+	FILE *f = fopen(path, "r");
+	if (!f)
+		return GL_FALSE;
+	int capacity = 0;
+	char line[4096];
+	while (fgets(line, sizeof(line), f)) {
+		char *tab = strchr(line, '\t');
+		if (line[0] == '#' || !tab)
+			continue;
+		/* a name cut short would never match, so it's left out */
+		size_t nameLength = (size_t)(tab - line);
+		if (nameLength >= sizeof(b->baseline[0].name)) {
+			fprintf(stderr, "ERROR: result name in %s is too long .. skipping\n", path);
+			continue;
+		}
+		if (b->numBaseline == capacity) {
+			capacity = capacity ? 2 * capacity : 64;
+			BaselineResult *results = (BaselineResult *)realloc(b->baseline, capacity * sizeof(BaselineResult));
+			if (!results) {
+				fclose(f);
+				return GL_FALSE;
+			}
+			b->baseline = results;
+		}
+		BaselineResult *result = &b->baseline[b->numBaseline];
+		memcpy(result->name, line, nameLength);
+		result->name[nameLength] = 0;
+		result->numTimes = 0;
+		for (char *p = tab + 1, *end; result->numTimes < MAX_BENCHMARK_REPS; p = end) {
+			double time = strtod(p, &end);
+			if (end == p)
+				break;
+			result->times[result->numTimes++] = time;
+		}
+		if (result->numTimes > 0)
+			++b->numBaseline;
+	}
+	fclose(f);
+	return GL_TRUE;
+}
+
+/* the 97.5% quantile of student's t distribution from the cornish-fisher expansion, which is within
+   1% of the exact one from 2 degrees of freedom up */
+double getStudentT975(double degreesOfFreedom) {
+	double z = 1.959963985;
+	double z2 = z * z;
+	double v = degreesOfFreedom;
+	return z + z * (z2 + 1.0) / (4.0 * v)
+		+ z * ((5.0 * z2 + 16.0) * z2 + 3.0) / (96.0 * v * v)
+		+ z * (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) / (384.0 * v * v * v)
+		+ z * ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) / (92160.0 * v * v * v * v);
+}
+
+void getLogTimeStats(const double *times, int count, double *mean, double *variance) {
+	*mean = 0.0;
+	for (int i = 0; i < count; ++i)
+		*mean += log(times[i]);
+	*mean /= count;
+	*variance = 0.0;
+	for (int i = 0; i < count; ++i)
+		*variance += (log(times[i]) - *mean) * (log(times[i]) - *mean);
+	*variance /= count - 1;
+}
+
+/* how many times slower the new times are than the old ones, as the ratio of their geometric means,
+   and a 95% confidence interval for it from welch's t-test on the log times. timings are skewed
+   towards slow outliers and noise tends to scale with the time, both of which the logs take care of */
+void compareBenchmarkTimes(const double *times, int count, const double *oldTimes, int oldCount, double *ratio, double *low, double *high) {
+	double mean, variance, oldMean, oldVariance;
+	getLogTimeStats(times, count, &mean, &variance);
+	getLogTimeStats(oldTimes, oldCount, &oldMean, &oldVariance);
+	double error = variance / count;
+	double oldError = oldVariance / oldCount;
+	double errorSquared = error * error / (count - 1) + oldError * oldError / (oldCount - 1);
+	double degreesOfFreedom = errorSquared > 0.0 ? (error + oldError) * (error + oldError) / errorSquared : 1.0e+9;
+	double margin = getStudentT975(degreesOfFreedom) * sqrt(error + oldError);
+	*ratio = exp(mean - oldMean);
+	*low = exp(mean - oldMean - margin);
+	*high = exp(mean - oldMean + margin);
+}
+
+/* adds a result to the baseline being saved, and compares it to the one being compared to. it only
+   counts as slower if the whole confidence interval is beyond the tolerance, so noise alone won't
+   fail a run, while a slowdown that is smaller than the noise can't be told apart from it */
+void checkBenchmarkResult(const char *name, const double *times, int count) {
+	Benchmark *b = &benchmark;
+	if (b->baselineFile) {
+		fprintf(b->baselineFile, "%s\t", name);
+		for (int i = 0; i < count; ++i)
+			fprintf(b->baselineFile, "%s%.9f", i > 0 ? " " : "", times[i]);
+		fprintf(b->baselineFile, "\n");
+	}
+	if (!b->compare)
+		return;
+
+	const BaselineResult *old = NULL;
+	for (int i = 0; i < b->numBaseline && !old; ++i) {
+		if (strcmp(b->baseline[i].name, name) == 0)
+			old = &b->baseline[i];
+	}
+	/* fewer times than a baseline is saved with leave too few degrees of freedom for the interval */
+	if (!old || old->numTimes < MIN_BASELINE_REPS) {
+		printf("    not in the baseline\n");
+		++b->numMissing;
+		return;
+	}
+	double ratio, low, high;
+	compareBenchmarkTimes(times, count, old->times, old->numTimes, &ratio, &low, &high);
+	const char *verdict = "same";
+	if (low > 1.0 + b->tolerance / 100.0) {
+		verdict = "SLOWER";
+		++b->numRegressions;
+	} else if (high < 1.0 - b->tolerance / 100.0) {
+		verdict = "faster";
+	}
+	printf("    %.3fx the baseline time, 95%% between %.3fx and %.3fx .. %s\n", ratio, low, high, verdict);
+	++b->numCompared;
+}
 
-	int dX = +abs(xend - x);
-	int dY = -abs(yend - y);
-	int signX = x < xend ? +1 : -1;
-	int signY = y < yend ? +1 : -1;
-	int error = dX + dY;
+/* times every engine on every pattern. each repetition re-uploads the starting cells and runs the
+   same number of generations between two glFinish calls, after some untimed warmup repetitions */
+void runUpdateBenchmarks(FILE *json) {
+	Benchmark *b = &benchmark;
+	int numBuiltIn = (int)(sizeof(benchmarkPatterns) / sizeof(benchmarkPatterns[0]));
+	int numEngines = (int)(sizeof(benchmarkEngines) / sizeof(benchmarkEngines[0]));
+	int numResults = 0;
+	for (int i = 0; i < numBuiltIn + b->numFiles; ++i) {
+		BenchmarkPattern given = { NULL, NULL };
+		const BenchmarkPattern *pattern = &given;
+		if (i < numBuiltIn) {
+			pattern = &benchmarkPatterns[i];
+		} else {
+			given.name = b->files[i - numBuiltIn];
+			given.source = b->files[i - numBuiltIn];
+		}
+		PackedCells start;
+		if (!loadBenchmarkPattern(pattern, &start))
+			continue;
 
-	for (;;) {
-		if (x >= 0 && x < numCellsX && y >= 0 && y < numCellsY) {
-			/* this can actually be pretty slow for long lines on huge cell fields
-			   it would probably be much faster to "render" a line primitive instead
-			   of setting each pixel manually, but that is quite complicated becaue
-			   of the way that the cells are stored in a single bit.. */
-			uint32_t cellColumn;
-			glReadPixels(x, y / 32, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &cellColumn);
-			if (value)
-				cellColumn |= (1 << (y & 31));
-			else
-				cellColumn &= ~(1 << (y & 31));
-			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y / 32, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &cellColumn);
+		double numCells = (double)start.columnsX * (double)start.columnsY * 32.0;
+		int generations = b->generations;
+		if (generations < 1) {
+			generations = (int)(BENCHMARK_CELL_UPDATES / (uint64_t)numCells);
+			generations = generations < 16 ? 16 : generations > 10240 ? 10240 : generations;
 		}
 
-		if (x == xend && y == yend)
-			break;
+		for (int e = 0; e < numEngines; ++e) {
+			const BenchmarkEngine *engine = &benchmarkEngines[e];
+			double times[MAX_BENCHMARK_REPS];
+			for (int r = -b->warmups; r < b->reps; ++r) {
+				setPackedCells(&start);
+				glFinish();
+				uint64_t startTime = glfwGetTimerValue();
+				for (int g = 0; g < generations; ++g)
+					engine->update();
+				glFinish();
+				uint64_t endTime = glfwGetTimerValue();
+				if (r >= 0)
+					times[r] = (endTime > startTime ? endTime - startTime : startTime - endTime) / (double)glfwGetTimerFrequency();
+			}
 
-		int error2 = 2 * error;
-		if (error2 >= dY) {
-			error += dY;
-			x += signX;
-		}
-		if (error2 <= dX) {
-			error += dX;
-			y += signY;
+			BenchmarkStats stats;
+			getBenchmarkStats(times, b->reps, &stats);
+			double psPerCell = stats.median * 1.0e+12 / (numCells * generations);
+			printf("%-20s %-16s %6d x %-6d %5d gens  median %9.3f ms  sd %5.1f%%  %7.2f ps per cell\n",
+				pattern->name, engine->name, start.columnsX, start.columnsY * 32, generations,
+				stats.median * 1.0e+3, 100.0 * sqrt(stats.variance) / stats.mean, psPerCell);
+			char name[256];
+			snprintf(name, sizeof(name), "%s, %s, %d x %d, %d generations",
+				pattern->name, engine->name, start.columnsX, start.columnsY * 32, generations);
+			checkBenchmarkResult(name, times, b->reps);
+
+			if (json) {
+				fprintf(json, "%s\n\t\t{ \"pattern\": ", numResults > 0 ? "," : "");
+				writeJsonString(json, pattern->name);
+				fprintf(json, ", \"engine\": ");
+				writeJsonString(json, engine->name);
+				fprintf(json, ", \"width\": %d, \"height\": %d, \"generations\": %d,\n\t\t  \"times\": [",
+					start.columnsX, start.columnsY * 32, generations);
+				for (int r = 0; r < b->reps; ++r)
+					fprintf(json, "%s%.9f", r > 0 ? ", " : "", times[r]);
+				fprintf(json, "],\n\t\t  \"median\": %.9f, \"mean\": %.9f, \"variance\": %.9e, \"min\": %.9f, \"max\": %.9f, \"psPerCell\": %.4f }",
+					stats.median, stats.mean, stats.variance, stats.min, stats.max, psPerCell);
+			}
+			++numResults;
 		}
+		freePackedCells(&start);
 	}
 }
 
-void onMouseWheel(GLFWwindow *window, double dX, double dY) {
-	if (keyModsArePressed()) {
-		float mX = (float)(mouseX / windowWidth);
-		float mY = (float)(mouseY / windowHeight);
-		float centerX = offsetX + mX * scaleX * scale;
-		float centerY = offsetY + mY * scaleY * scale;
-		/* we get visible rendering glitches with very small scales so we need to clamp */
-		if (dY > 0)
-			scale = fmaxf(scale / 1.1f, 0.0001f);
-		else if (dY < 0)
-			scale = fminf(scale * 1.1f, 10.0f);
-		offsetX = centerX - mX * scaleX * scale;
-		offsetY = centerY - mY * scaleY * scale;
-	} else {
-		if (dY > 0) {
-			if (framesPerUpdate > 1)
-				framesPerUpdate /= 2;
-			else
-				updatesPerFrame *= 2;
-		} else if (dY < 0) {
-			if (updatesPerFrame > 1)
-				updatesPerFrame /= 2;
-			else
-				framesPerUpdate *= 2;
-		}
+/* peak resident memory since the last resetPeakMemory. only linux lets the peak be reset, elsewhere
+   it is the peak of the whole run so far */
+void resetPeakMemory(void) {
+#ifdef __linux__
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+	if (f) {
+		fputs("5", f);
+		fclose(f);
 	}
+#endif
 }
 
-void onKey(GLFWwindow *window, int key, int scancode, int action, int mods) {
-	if (action != GLFW_PRESS && action != GLFW_REPEAT)
-		return;
+size_t getPeakMemory(void) {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#elif defined(__linux__)
+	FILE *f = fopen("/proc/self/status", "r");
+	if (!f)
+		return 0;
+	char line[256];
+	unsigned long peak = 0;
+	while (fgets(line, sizeof(line), f) && sscanf(line, "VmHWM: %lu kB", &peak) != 1)
+		;
+	fclose(f);
+	return (size_t)peak << 10;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return (size_t)usage.ru_maxrss;
+#else
+	return (size_t)usage.ru_maxrss << 10;
+#endif
+#endif
+}
 
-	switch (key) {
-		case GLFW_KEY_ESCAPE: {
-			GLFWmonitor *monitor = glfwGetWindowMonitor(window);
-			if (monitor) {
-				int width, height;
-				glfwGetMonitorWorkarea(monitor, NULL, NULL, &width, &height);
-				glfwSetWindowMonitor(window, NULL, (windowWidth - 1280) / 2, (height - 720) / 2, 1280, 720, 60);
-			} 
-			else 
-				glfwSetWindowShouldClose(window, GLFW_TRUE);
-		}break;
-		case GLFW_KEY_ENTER:
-		case GLFW_KEY_PAUSE:
-			isRunning = !isRunning;
-			break;
-		case GLFW_KEY_C:
-		case GLFW_KEY_HOME:
-			centerCellsOnScreen();
-			break;
-		case GLFW_KEY_B:
-			cellBorderIsOn = !cellBorderIsOn;
-			break;
-		case GLFW_KEY_V:
-			vsyncIsOn = !vsyncIsOn;
-			glfwSwapInterval(vsyncIsOn);
-			break;
-		case GLFW_KEY_EQUAL:
-		case GLFW_KEY_KP_ADD:
-			onMouseWheel(window, 0.0, 1.0);
-			break;
-		case GLFW_KEY_MINUS:
-		case GLFW_KEY_KP_SUBTRACT:
-			onMouseWheel(window, 0.0, -1.0);
-			break;
-		case GLFW_KEY_LEFT:
-			offsetX -= scale * scaleX * 0.05f;
-			break;
-		case GLFW_KEY_RIGHT:
-			offsetX += scale * scaleX * 0.05f;
-			break;
-		case GLFW_KEY_UP:
-			offsetY += scale * scaleY * 0.05f;
-			break;
-		case GLFW_KEY_DOWN:
-			offsetY -= scale * scaleY * 0.05f;
-			break;
-		case GLFW_KEY_L:
-			backgroundColor = 0.9f;
-			deadColor = 1.0f;
-			aliveColor = 0.0f;
-			break;
-		case GLFW_KEY_D:
-			backgroundColor = 0.0f;
-			deadColor = 0.1f;
-			aliveColor = 1.0f;
-			break;
-		case GLFW_KEY_SPACE:
-		case GLFW_KEY_KP_ENTER:
-		case GLFW_KEY_PERIOD:
-		case GLFW_KEY_TAB:
-		case GLFW_KEY_S:
-			updateCells();
-			break;
-		case GLFW_KEY_F11:
-		case GLFW_KEY_F: {
-			GLFWmonitor *monitor = glfwGetWindowMonitor(window);
-			GLFWmonitor *primaryMonitor = glfwGetPrimaryMonitor();
-			int width, height;
-			glfwGetMonitorWorkarea(primaryMonitor, NULL, NULL, &width, &height);
-			const GLFWvidmode *mode = glfwGetVideoMode(primaryMonitor);
-			if (!monitor)
-				glfwSetWindowMonitor(window, primaryMonitor, 0, 0, width, height, mode->refreshRate);
-			else
-				glfwSetWindowMonitor(window, NULL, (width - 1280) / 2, (height - 720) / 2, 1280, 720, mode->refreshRate);
-		} break;
-		case GLFW_KEY_BACKSPACE:
-		case GLFW_KEY_DELETE:
-			clearCells();
-			break;
-		default: break;
+/* the stages every loader goes through, although some of them do two stages in one go */
+typedef enum LoaderStage {
+	STAGE_READ,
+	STAGE_TOKENISE,
+	STAGE_EXPAND,
+	STAGE_PACK,
+	STAGE_UPLOAD,
+	NUM_LOADER_STAGES
+} LoaderStage;
+
+const char *loaderStageNames[NUM_LOADER_STAGES] = { "read", "tokenise", "expand", "pack", "upload" };
+
+typedef struct StageTimes {
+	double times[NUM_LOADER_STAGES][MAX_BENCHMARK_REPS];
+	size_t peaks[NUM_LOADER_STAGES];
+	GLboolean isUsed[NUM_LOADER_STAGES];
+	int rep;
+	LoaderStage stage;
+	double startTime;
+} StageTimes;
+
+void beginStage(StageTimes *t, LoaderStage stage) {
+	resetPeakMemory();
+	t->stage = stage;
+	t->startTime = glfwGetTime();
+}
+
+void endStage(StageTimes *t) {
+	double time = glfwGetTime() - t->startTime;
+	size_t peak = getPeakMemory();
+	if (t->rep >= 0) {
+		t->times[t->stage][t->rep] = time;
+		if (peak > t->peaks[t->stage])
+			t->peaks[t->stage] = peak;
+		t->isUsed[t->stage] = GL_TRUE;
 	}
 }
 
-void onFileDragAndDrop(GLFWwindow *window, int numFiles, const char **files) {
+/* writes a synthetic world in one of the formats, and reads it back one timed stage at a time
+   with the same building blocks the pattern loaders use */
+typedef struct LoaderBenchmark {
+	const char *name;
+	const char *extension;
+	GLboolean (*write)(FILE *f, const PackedCells *cells);
+	GLboolean (*read)(const char *data, size_t size, StageTimes *t, PackedCells *cells);
+} LoaderBenchmark;
 
-	const char *file = files[0];
-	FILE *f = fopen(file, "rt");
-	if (!f) {
-		printf("couldnt open %s\n", file);
-		return;
-	}
+GLboolean writeRleBenchmark(FILE *f, const PackedCells *cells) {
+	return writeRle(f, cells->columns, cells->columnsX, cells->columnsY * 32, 0);
+}
 
-	char ignored;
+GLboolean readRleBenchmark(const char *data, size_t size, StageTimes *t, PackedCells *cells) {
+	const char *end = data + size;
+	beginStage(t, STAGE_TOKENISE);
+	const char *header = data;
+	while (header < end && *header == '#') {
+		while (header < end && *header != '\n')
+			++header;
+		++header;
+	}
 	int width, height;
-	
-	/* life 1.06 file (.life) */
-	fseek(f, 0, SEEK_SET);
-	if (1 == fscanf(f, " #Life 1.06%c ", &ignored)) {
-		printf("loading %s .. ", file);
-		int minX = 0;
-		int maxX = 0;
-		int minY = 0;
-		int maxY = 0;
-		int x, y;
-		while (2 == fscanf(f, " %d %d ", &x, &y)) {
-			if (x < minX) minX = x;
-			if (x > maxX) maxX = x;
-			if (y < minY) minY = y;
-			if (y > maxY) maxY = y;
-		}
-		width = 1 + maxX - minX;
-		height = 1 + maxY - minY;
-		if (width < 1 && height < 1) {
-			printf("invalid life 1.06 file\n");
-			return;
-		}
-		if (width > maxTextureSize || height > maxTextureSize) {
-			printf("%d x %d texture is larger than the maximum %d x %d\n", width, height, maxTextureSize, maxTextureSize);
-			return;
-		}
+	if (header >= end || 2 != sscanf(header, " x = %d , y = %d ", &width, &height) || !allocPackedCells(cells, width, height))
+		return GL_FALSE;
+	const char *body = findRleBody(data, end);
+	ParallelRle *rle = scanRleParallel(body, end, cells);
+	endStage(t);
+	if (!rle)
+		return GL_FALSE;
+
+	beginStage(t, STAGE_EXPAND);
+	parallelFor(rle->numChunks, decodeRleChunk, rle);
+	GLboolean isValid = rle->numInvalid == 0;
+	free(rle);
+	endStage(t);
+	return isValid;
+}
+
+GLboolean writeLifeBenchmark(FILE *f, const PackedCells *cells) {
+	fprintf(f, "#Life 1.06\n");
+	for (int row = cells->columnsY * 32 - 1; row >= 0; --row) {
+		const uint32_t *columns = &cells->columns[(size_t)(row / 32) * (size_t)cells->columnsX];
+		for (int x = 0; x < cells->columnsX; ++x)
+			if (columns[x] >> (row % 32) & 1)
+				fprintf(f, "%d %d\n", x, cells->columnsY * 32 - 1 - row);
+	}
+	return !ferror(f);
+}
+
+GLboolean readLifeBenchmark(const char *data, size_t size, StageTimes *t, PackedCells *cells) {
+	const char *end = data + size;
+	beginStage(t, STAGE_TOKENISE);
+	const char *p = data;
+	while (p < end && *p != '\n')
+		++p;
+	CellCoordinates coordinates;
+	GLboolean isOk = parseLifeCoordinates(p, end, &coordinates);
+	endStage(t);
+	if (!isOk)
+		return GL_FALSE;
+
+	beginStage(t, STAGE_EXPAND);
+	isOk = allocPackedCells(cells, 1 + coordinates.maxX - coordinates.minX, 1 + coordinates.maxY - coordinates.minY);
+	if (isOk)
+		scatterCellCoordinates(&coordinates, cells);
+	free(coordinates.xy);
+	endStage(t);
+	return isOk;
+}
+
+/* dark pixels are alive, just like when images are loaded */
+GLboolean writePgmBenchmark(FILE *f, const PackedCells *cells) {
+	int width = cells->columnsX;
+	int height = cells->columnsY * 32;
+	uint8_t *row = (uint8_t *)malloc((size_t)width);
+	if (!row)
+		return GL_FALSE;
+	fprintf(f, "P5\n%d %d\n255\n", width, height);
+	for (int y = height - 1; y >= 0; --y) {
+		const uint32_t *columns = &cells->columns[(size_t)(y / 32) * (size_t)width];
+		for (int x = 0; x < width; ++x)
+			row[x] = columns[x] >> (y % 32) & 1 ? 0 : 255;
+		fwrite(row, 1, (size_t)width, f);
+	}
+	free(row);
+	return !ferror(f);
+}
 
-		uint8_t *cells = (uint8_t *)calloc((size_t)width * (size_t)height, 1);
+GLboolean readPgmBenchmark(const char *data, size_t size, StageTimes *t, PackedCells *cells) {
+	beginStage(t, STAGE_TOKENISE);
+	const char *p = data + 2;
+	int header[3];
+	GLboolean isOk = parsePnmHeader(&p, data + size, header, 3);
+	endStage(t);
+	if (!isOk || !allocPackedCells(cells, header[0], header[1]))
+		return GL_FALSE;
 
-		fseek(f, 0, SEEK_SET);
-		fscanf(f, " #Life 1.06 ");
-		while (2 == fscanf(f, " %d %d ", &x, &y)) {
-			x -= minX;
-			y -= minY;
-			y = height - y - 1;
-			cells[y * width + x] = 255;
+	beginStage(t, STAGE_PACK);
+	const uint8_t *lastRow = (const uint8_t *)p + (size_t)(header[1] - 1) * (size_t)header[0];
+	packRows(lastRow, -(ptrdiff_t)header[0], header[0], header[1], 127, GL_FALSE, cells);
+	endStage(t);
+	return GL_TRUE;
+}
+
+GLboolean writePngBenchmark(FILE *f, const PackedCells *cells) {
+	int width = cells->columnsX;
+	int height = cells->columnsY * 32;
+	uint8_t *pixels = (uint8_t *)malloc((size_t)width * (size_t)height * 4);
+	uint8_t *raw = (uint8_t *)malloc(getPngRawSize(width, height));
+	uint8_t *out = (uint8_t *)malloc(pngBound(width, height));
+	GLboolean isOk = pixels && raw && out;
+	if (isOk) {
+		for (int y = 0; y < height; ++y) {
+			const uint32_t *columns = &cells->columns[(size_t)(y / 32) * (size_t)width];
+			for (int x = 0; x < width; ++x)
+				memset(pixels + ((size_t)y * width + x) * 4, columns[x] >> (y % 32) & 1 ? 0 : 255, 4);
 		}
+		size_t size = encodePng(pixels, width, height, raw, out);
+		isOk = fwrite(out, 1, size, f) == size;
+	}
+	free(pixels);
+	free(raw);
+	free(out);
+	return isOk;
+}
 
-		setPatternName(file);
-		setCells(cells, width, height);
-		free(cells);
-		printf("done\n");
-		return;
+GLboolean readPngBenchmark(const char *data, size_t size, StageTimes *t, PackedCells *cells) {
+	beginStage(t, STAGE_EXPAND);
+	int width, height, comp;
+	stbi_set_flip_vertically_on_load(0);
+	stbi_uc *pixels = stbi_load_from_memory((const stbi_uc *)data, (int)size, &width, &height, &comp, STBI_grey);
+	endStage(t);
+	if (!pixels || !allocPackedCells(cells, width, height)) {
+		stbi_image_free(pixels);
+		return GL_FALSE;
 	}
 
-	/* RLE life file (.rle) */
-	fseek(f, 0, SEEK_SET);
-	char lineBuffer[1024];
-	char *line;
-	do {
-		line = fgets(lineBuffer, sizeof(lineBuffer), f);
-	} while (line && line[0] == '#');
-	if (2 == sscanf(line, " x = %d , y = %d ", &width, &height)) {
+	beginStage(t, STAGE_PACK);
+	const stbi_uc *lastRow = pixels + (size_t)(height - 1) * (size_t)width;
+	packRows(lastRow, -(ptrdiff_t)width, width, height, 127, GL_FALSE, cells);
+	stbi_image_free(pixels);
+	endStage(t);
+	return GL_TRUE;
+}
 
-		printf("loading %s .. ", file);
+const LoaderBenchmark loaderBenchmarks[] = {
+	{ "rle", "rle", writeRleBenchmark, readRleBenchmark },
+	{ "life 1.06", "life", writeLifeBenchmark, readLifeBenchmark },
+	{ "pgm", "pgm", writePgmBenchmark, readPgmBenchmark },
+	{ "png", "png", writePngBenchmark, readPngBenchmark },
+};
 
-		if (width > maxTextureSize || height > maxTextureSize) {
-			printf("%d x %d texture is larger than the maximum %d x %d\n", 
-				width, height, maxTextureSize, maxTextureSize);
-			return;
+const int loaderBenchmarkSizes[] = { 1024, 2048, 4096 };
+
+#define LOADER_BENCHMARK_DENSITY 0.25
+
+size_t countLiveCells(const PackedCells *cells) {
+	size_t count = 0;
+	size_t numColumns = (size_t)cells->columnsX * (size_t)cells->columnsY;
+	for (size_t i = 0; i < numColumns; ++i)
+		for (uint32_t c = cells->columns[i]; c; c &= c - 1)
+			++count;
+	return count;
+}
+
+/* times every stage of loading each format at each size. the files are written fresh and read
+   back from the page cache, so the read stage is how fast a mapping can be paged in, which is
+   what the pattern loaders do. MB/s is always of the file, to make the stages comparable */
+void runLoaderBenchmarks(FILE *json) {
+	Benchmark *b = &benchmark;
+	makeDirectory(CACHE_DIRECTORY);
+	int numResults = 0;
+	for (int i = 0; i < (int)(sizeof(loaderBenchmarkSizes) / sizeof(loaderBenchmarkSizes[0])); ++i) {
+		WorldSpec spec = { WORLD_SOUP, loaderBenchmarkSizes[i], loaderBenchmarkSizes[i], LOADER_BENCHMARK_DENSITY, 1 };
+		PackedCells source;
+		if (!generateWorld(&spec, &source)) {
+			fprintf(stderr, "ERROR: not enough memory for a %d x %d world .. skipping\n", spec.width, spec.height);
+			continue;
 		}
+		size_t numLive = countLiveCells(&source);
 
-		uint8_t *cells = (uint8_t *)calloc((size_t)width * (size_t)height, 1);
-		int cursorX = 0;
-		int cursorY = height - 1;
-		for (;;) {
-			
-			int runCount = 1;
-			char tag;
-
-			if (2 == fscanf(f, " %d %c ", &runCount, &tag)) {
-				if (tag == 'o') {
-					memset(&cells[cursorY * width + cursorX], 255, runCount);
-					cursorX += runCount;
-				} else if (tag == 'b') {
-					cursorX += runCount;
-				} else if (tag == '$') {
-					cursorY -= runCount;
-					cursorX = 0;
-				}
+		for (int j = 0; j < (int)(sizeof(loaderBenchmarks) / sizeof(loaderBenchmarks[0])); ++j) {
+			const LoaderBenchmark *loader = &loaderBenchmarks[j];
+			char path[512];
+			snprintf(path, sizeof(path), "%s/loader-benchmark-%d.%s", CACHE_DIRECTORY, spec.width, loader->extension);
+			FILE *f = fopen(path, "wb");
+			GLboolean isOk = f && loader->write(f, &source);
+			if (f)
+				isOk &= fclose(f) == 0;
+			if (!isOk) {
+				fprintf(stderr, "ERROR: failed to write %s .. skipping\n", path);
+				remove(path);
 				continue;
 			}
-			
-			if (1 == fscanf(f, " %c ", &tag)) {
-				if (tag == '!')
+
+			StageTimes t;
+			memset(&t, 0, sizeof(t));
+			size_t fileSize = 0;
+			for (t.rep = -b->warmups; t.rep < b->reps && isOk; ++t.rep) {
+				/* mapping alone reads nothing, so every page is touched */
+				MappedFile file;
+				beginStage(&t, STAGE_READ);
+				isOk = mapFile(&file, path);
+				volatile uint8_t sum = 0;
+				for (size_t k = 0; isOk && k < file.size; k += 4096)
+					sum += (uint8_t)file.data[k];
+				endStage(&t);
+				if (!isOk)
 					break;
-				else if (tag == '$') {
-					--cursorY;
-					cursorX = 0;
-				} else if (tag == 'o')
-					cells[cursorY * width + cursorX++] = 255;
-				else if (tag == 'b')
-					++cursorX;
+				fileSize = file.size;
+
+				PackedCells cells;
+				cells.columns = NULL;
+				isOk = loader->read(file.data, file.size, &t, &cells);
+				unmapFile(&file);
+				if (isOk && countLiveCells(&cells) != numLive) {
+					fprintf(stderr, "ERROR: %s came back with %zu instead of %zu live cells\n", path, countLiveCells(&cells), numLive);
+					isOk = GL_FALSE;
+				}
+				if (isOk) {
+					beginStage(&t, STAGE_UPLOAD);
+					setPackedCells(&cells);
+					glFinish();
+					endStage(&t);
+				}
+				freePackedCells(&cells);
+			}
+			remove(path);
+			if (!isOk) {
+				fprintf(stderr, "ERROR: failed to load %s\n", path);
 				continue;
 			}
-			
-			return;
-		}
 
-		setPatternName(file);
-		setCells(cells, width, height);
-		free(cells);
-		printf("done\n");
-		return;
+			printf("%-10s %5d x %-5d %8.2f MB\n", loader->name, spec.width, spec.height, fileSize / 1.0e+6);
+			for (int stage = 0; stage < NUM_LOADER_STAGES; ++stage) {
+				if (!t.isUsed[stage])
+					continue;
+				BenchmarkStats stats;
+				getBenchmarkStats(t.times[stage], b->reps, &stats);
+				double megabytesPerSecond = fileSize / 1.0e+6 / stats.median;
+				printf("    %-10s median %9.3f ms  %9.1f MB/s  peak %8.1f MB\n", loaderStageNames[stage],
+					stats.median * 1.0e+3, megabytesPerSecond, t.peaks[stage] / 1.0e+6);
+				char name[256];
+				snprintf(name, sizeof(name), "%s, %d x %d, %s", loader->name, spec.width, spec.height, loaderStageNames[stage]);
+				checkBenchmarkResult(name, t.times[stage], b->reps);
+				if (json) {
+					fprintf(json, "%s\n\t\t{ \"format\": ", numResults > 0 ? "," : "");
+					writeJsonString(json, loader->name);
+					fprintf(json, ", \"width\": %d, \"height\": %d, \"fileSize\": %zu, \"stage\": \"%s\",\n\t\t  \"times\": [",
+						spec.width, spec.height, fileSize, loaderStageNames[stage]);
+					for (int r = 0; r < b->reps; ++r)
+						fprintf(json, "%s%.9f", r > 0 ? ", " : "", t.times[stage][r]);
+					fprintf(json, "],\n\t\t  \"median\": %.9f, \"mean\": %.9f, \"variance\": %.9e, \"mbPerSecond\": %.3f, \"peakBytes\": %zu }",
+						stats.median, stats.mean, stats.variance, megabytesPerSecond, t.peaks[stage]);
+				}
+				++numResults;
+			}
+		}
+		freePackedCells(&source);
 	}
+}
 
-	/* image file */
-	fclose(f);
-	int comp;
-	if (stbi_info(file, &width, &height, &comp)) {
+/* runs the update benchmarks, or the loader ones, and writes the results as json if asked to. it can
+   also save them as the baseline for this machine, or compare them to it and fail on a regression */
+void runBenchmarks(void) {
+	Benchmark *b = &benchmark;
+	if (b->reps < 1)
+		b->reps = 1;
+	if ((b->saveBaseline || b->compare) && b->reps < MIN_BASELINE_REPS) {
+		printf("baselines need at least %d repetitions, using %d\n", MIN_BASELINE_REPS, MIN_BASELINE_REPS);
+		b->reps = MIN_BASELINE_REPS;
+	}
+	if (b->reps > MAX_BENCHMARK_REPS)
+		b->reps = MAX_BENCHMARK_REPS;
+	if (b->warmups < 0)
+		b->warmups = 0;
 
-		stbi_set_flip_vertically_on_load(1);
-		stbi_uc *cells = stbi_load(file, &width, &height, &comp, STBI_grey);
-		if (!cells) {
-			printf("couldnt load %s: %s\n", file, stbi_failure_reason());
+	char profile[128];
+	char baselinePath[512];
+	getBenchmarkProfile(profile, sizeof(profile));
+	if (b->baselinePath)
+		snprintf(baselinePath, sizeof(baselinePath), "%s", b->baselinePath);
+	else
+		snprintf(baselinePath, sizeof(baselinePath), "%s/%s-%s.txt", BASELINE_DIRECTORY, profile, b->loaders ? "loaders" : "updates");
+	if (b->compare) {
+		if (!readBaseline(baselinePath)) {
+			fprintf(stderr, "ERROR: failed to read baseline %s, save one with --save-baseline first .. aborting\n", baselinePath);
+			b->exitCode = 2;
 			return;
 		}
-
-		printf("loading %s .. ", file);
-
-		if (width > maxTextureSize || height > maxTextureSize) {
-			printf("%d x %d texture is larger than the maximum %d x %d\n", 
-				width, height, maxTextureSize, maxTextureSize);
-			return;
+		printf("comparing to %s\n", baselinePath);
+	}
+	if (b->saveBaseline) {
+		if (!b->baselinePath)
+			makeDirectory(BASELINE_DIRECTORY);
+		b->baselineFile = fopen(baselinePath, "w");
+		if (!b->baselineFile) {
+			fprintf(stderr, "ERROR: failed to open %s .. not saving a baseline\n", baselinePath);
+		} else {
+			fprintf(b->baselineFile, "# gpu life %s baseline\n# renderer: %s\n# version: %s\n# cores: %d\n# time: %lld\n",
+				b->loaders ? "loader" : "update", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION),
+				getNumCores(), (long long)time(NULL));
 		}
+	}
+	/* a wrong result fails the run just like a regression does */
+	for (int i = 0; i < (int)(sizeof(selfChecks) / sizeof(selfChecks[0])); ++i) {
+		GLboolean isOk = selfChecks[i].check();
+		printf("%s self check %s\n", selfChecks[i].name, isOk ? "passed" : "FAILED");
+		if (!isOk)
+			b->exitCode = 1;
+	}
 
-		int64_t size = (int64_t)width * (int64_t)height;
-		for (int64_t i = 0; i < size; ++i) {
-			if (cells[i] > 127)
-				cells[i] = 0;
-			else
-				cells[i] = 255;
-		}
+	vsyncIsOn = 0;
+	glfwSwapInterval(0);
+	glfwSetWindowTitle(window, "GPU Life - Benchmark");
 
-		setPatternName(file);
-		setCells(cells, width, height);
-		stbi_image_free(cells);
-		printf("done\n");
-		return;
+	FILE *json = NULL;
+	if (b->jsonPath) {
+		json = fopen(b->jsonPath, "wb");
+		if (!json)
+			fprintf(stderr, "ERROR: failed to open %s .. not writing results\n", b->jsonPath);
+	}
+	if (json) {
+		fprintf(json, "{\n\t\"renderer\": ");
+		writeJsonString(json, (const char *)glGetString(GL_RENDERER));
+		fprintf(json, ",\n\t\"version\": ");
+		writeJsonString(json, (const char *)glGetString(GL_VERSION));
+		fprintf(json, ",\n\t\"profile\": ");
+		writeJsonString(json, profile);
+		fprintf(json, ",\n\t\"cores\": %d,\n\t\"time\": %lld,\n\t\"benchmark\": \"%s\",\n\t\"warmups\": %d,\n\t\"reps\": %d,\n\t\"results\": [",
+			getNumCores(), (long long)time(NULL), b->loaders ? "loaders" : "updates", b->warmups, b->reps);
 	}
 
-	printf("unknown file format %s\n", file);
+	if (b->loaders)
+		runLoaderBenchmarks(json);
+	else
+		runUpdateBenchmarks(json);
+
+	if (json) {
+		fprintf(json, "\n\t]\n}\n");
+		if (fclose(json) != 0)
+			fprintf(stderr, "ERROR: failed to write %s\n", b->jsonPath);
+		else
+			printf("wrote %s\n", b->jsonPath);
+	}
+	if (b->baselineFile) {
+		if (fclose(b->baselineFile) != 0)
+			fprintf(stderr, "ERROR: failed to write %s\n", baselinePath);
+		else
+			printf("saved baseline %s\n", baselinePath);
+		b->baselineFile = NULL;
+	}
+	if (b->compare) {
+		if (b->numMissing > 0)
+			printf("%d results aren't in the baseline\n", b->numMissing);
+		if (b->numRegressions > 0) {
+			printf("%d of %d results are more than %.1lf%% slower than the baseline .. FAILED\n", b->numRegressions, b->numCompared, b->tolerance);
+			b->exitCode = 1;
+		} else if (b->numCompared == 0) {
+			printf("nothing to compare to in the baseline .. FAILED\n");
+			b->exitCode = 2;
+		} else {
+			printf("none of %d results are more than %.1lf%% slower than the baseline .. passed\n", b->numCompared, b->tolerance);
+		}
+		free(b->baseline);
+		b->baseline = NULL;
+	}
+	clearCells();
 }
+#endif
+
+int main(int argc, char **argv) {
+	initCrcTable();
+	const char *patternFile = NULL;
+	const char *exportPath = NULL;
+	int exportEvery = 1;
+	int exportFrames = 0;
+	const char *tracePath = NULL;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--export") == 0 && i + 1 < argc)
+			exportPath = argv[++i];
+		else if (strcmp(argv[i], "--every") == 0 && i + 1 < argc)
+			exportEvery = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			exportFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			tracePath = argv[++i];
+#ifdef BENCHMARK
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			benchmark.jsonPath = argv[++i];
+		else if (strcmp(argv[i], "--warmups") == 0 && i + 1 < argc)
+			benchmark.warmups = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+			benchmark.reps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--generations") == 0 && i + 1 < argc)
+			benchmark.generations = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--loaders") == 0)
+			benchmark.loaders = GL_TRUE;
+		else if (strcmp(argv[i], "--save-baseline") == 0)
+			benchmark.saveBaseline = GL_TRUE;
+		else if (strcmp(argv[i], "--compare") == 0)
+			benchmark.compare = GL_TRUE;
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+			benchmark.baselinePath = argv[++i];
+		else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+			benchmark.tolerance = atof(argv[++i]);
+		else if (benchmark.numFiles < MAX_BENCHMARK_FILES)
+			benchmark.files[benchmark.numFiles++] = argv[i];
+#else
+		else
+			patternFile = argv[i];
+#endif
+	}
 
-int main(void) {
 	glfwSetErrorCallback(onGlfwError);
 	int glfwOk = glfwInit();
 	if (!glfwOk) {
@@ -863,6 +6922,21 @@ int main(void) {
 		abort();
 	}
 
+	if (GLVersion.major > 3 || GLVersion.minor >= 2 || glfwExtensionSupported("GL_ARB_sync")) {
+		glFenceSync = (PFNGLFENCESYNCPROC)glfwGetProcAddress("glFenceSync");
+		glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)glfwGetProcAddress("glClientWaitSync");
+		glDeleteSync = (PFNGLDELETESYNCPROC)glfwGetProcAddress("glDeleteSync");
+		if (!glFenceSync || !glClientWaitSync || !glDeleteSync)
+			glFenceSync = NULL;
+	}
+	if (GLVersion.major > 3 || GLVersion.minor >= 3 || glfwExtensionSupported("GL_ARB_timer_query")) {
+		glQueryCounter = (PFNGLQUERYCOUNTERPROC)glfwGetProcAddress("glQueryCounter");
+		glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)glfwGetProcAddress("glGetQueryObjectui64v");
+		glGetInteger64v = (PFNGLGETINTEGER64VPROC)glfwGetProcAddress("glGetInteger64v");
+		if (!glQueryCounter || !glGetQueryObjectui64v || !glGetInteger64v)
+			glQueryCounter = NULL;
+	}
+
 	glfwSwapInterval(vsyncIsOn);
 	glfwSetFramebufferSizeCallback(window, onFramebufferResized);
 	glfwSetKeyCallback(window, onKey);
@@ -878,6 +6952,10 @@ int main(void) {
 	GLuint vertShader = compileShader(GL_VERTEX_SHADER, vertShaderSource);
 	GLuint fragShader = compileShader(GL_FRAGMENT_SHADER, renderShaderSource);
 	GLuint updateShader = compileShader(GL_FRAGMENT_SHADER, updateShaderSource);
+	GLuint runVertShader = compileShader(GL_VERTEX_SHADER, runVertShaderSource);
+	GLuint runFragShader = compileShader(GL_FRAGMENT_SHADER, runFragShaderSource);
+	GLuint hudVertShader = compileShader(GL_VERTEX_SHADER, hudVertShaderSource);
+	GLuint hudFragShader = compileShader(GL_FRAGMENT_SHADER, hudFragShaderSource);
 
 	GLuint renderShaders[2];
 	renderShaders[0] = vertShader;
@@ -887,6 +6965,14 @@ int main(void) {
 	updateShaders[0] = vertShader;
 	updateShaders[1] = updateShader;
 	updateProgram = linkShaderProgram(updateShaders, 2);
+	GLuint runShaders[2];
+	runShaders[0] = runVertShader;
+	runShaders[1] = runFragShader;
+	runProgram = linkShaderProgram(runShaders, 2);
+	GLuint hudShaders[2];
+	hudShaders[0] = hudVertShader;
+	hudShaders[1] = hudFragShader;
+	hudProgram = linkShaderProgram(hudShaders, 2);
 
 	uniformScale = glGetUniformLocation(renderProgram, "scale");
 	uniformOffset = glGetUniformLocation(renderProgram, "offset");
@@ -894,10 +6980,16 @@ int main(void) {
 	uniformBackgroundColor = glGetUniformLocation(renderProgram, "backgroundColor");
 	uniformDeadColor = glGetUniformLocation(renderProgram, "deadColor");
 	uniformAliveColor = glGetUniformLocation(renderProgram, "aliveColor");
+	uniformRunNumCells = glGetUniformLocation(runProgram, "numCells");
+	uniformHudWindowSize = glGetUniformLocation(hudProgram, "windowSize");
 
 	glDeleteShader(vertShader);
 	glDeleteShader(fragShader);
 	glDeleteShader(updateShader);
+	glDeleteShader(runVertShader);
+	glDeleteShader(runFragShader);
+	glDeleteShader(hudVertShader);
+	glDeleteShader(hudFragShader);
 
 	const float quadData[4][2] = {
 		{ -1, +1 },
@@ -906,7 +6998,22 @@ int main(void) {
 		{ +1, -1 },
 	};
 
-	GLuint vertexArray;
+	glGenVertexArrays(1, &runVertexArray);
+	glBindVertexArray(runVertexArray);
+	runPositionLocation = glGetAttribLocation(runProgram, "position");
+	glEnableVertexAttribArray(runPositionLocation);
+
+	glGenVertexArrays(1, &hudVertexArray);
+	glBindVertexArray(hudVertexArray);
+	glGenBuffers(1, &hudVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, hudVertexBuffer);
+	GLint hudPositionLocation = glGetAttribLocation(hudProgram, "position");
+	GLint hudColorLocation = glGetAttribLocation(hudProgram, "color");
+	glEnableVertexAttribArray(hudPositionLocation);
+	glVertexAttribPointer(hudPositionLocation, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void *)offsetof(HudVertex, x));
+	glEnableVertexAttribArray(hudColorLocation);
+	glVertexAttribPointer(hudColorLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void *)offsetof(HudVertex, color));
+
 	glGenVertexArrays(1, &vertexArray);
 	glBindVertexArray(vertexArray);
 
@@ -929,64 +7036,92 @@ int main(void) {
 	cellsWrite = createTexture(NULL, numCellsX, numCellsY / 32, GL_RED_INTEGER, GL_R32UI);
 	cellsReadFramebuffer = createFramebuffer(cellsRead);
 	cellsWriteFramebuffer = createFramebuffer(cellsWrite);
+	glGenBuffers(NUM_UPLOAD_BUFFERS, uploadBuffers);
 	glCheckErrors();
 
 	clearCells();
 	centerCellsOnScreen();
 
+	/* a pattern can be given on the command line as well as dropped on the window, and so can a synthetic world */
+	WorldSpec worldSpec;
+	if (patternFile && parseWorldSpec(patternFile, &worldSpec))
+		setWorld(&worldSpec);
+	else if (patternFile)
+		onFileDragAndDrop(window, 1, &patternFile);
+
+	/* exports from the command line start from the fully loaded pattern and step the world
+	   as fast as frames can be exported, so they come out the same every time */
+	GLboolean isExportingOffline = GL_FALSE;
+	if (exportPath) {
+		pollPatternLoad(GL_TRUE);
+		vsyncIsOn = 0;
+		glfwSwapInterval(0);
+		startExport(exportPath, exportEvery, exportFrames);
+		isExportingOffline = exporter.isExporting;
+		if (!isExportingOffline)
+			glfwSetWindowShouldClose(window, GLFW_TRUE);
+	}
+
 #ifdef BENCHMARK
-	const char *benchFile = "digital-clock.rle";
-	onFileDragAndDrop(window, 1, &benchFile);
-	int benchCellsX = numCellsX;
-	int benchCellsY = numCellsY;
-	vsyncIsOn = 0;
-	glfwSwapInterval(0);
-	glfwSetWindowTitle(window, "GPU Life - Benchmark");
-	glfwSetWindowSize(window, 1920, 1080);
-	centerCellsOnScreen();
-	int numBenchmarkUpdates = 10240;
-	printf("running benchmark ... ");
-	glFinish();
-	uint64_t startTime = glfwGetTimerValue();
-	for (int i = 0; i < numBenchmarkUpdates; ++i)
-		updateCells();
-	renderCells();
-	glfwSwapBuffers(window);
-	glFinish();
-	uint64_t endTime = glfwGetTimerValue();
-	double benchTime = (endTime > startTime ? endTime - startTime : startTime - endTime) / (double)glfwGetTimerFrequency();
-	double referenceTime = 3.20;
-	printf("done\n");
-	printf("total   %.2lf sec\n", benchTime);
-	printf("average %.2lf ms per frame\n", benchTime * 1.0e+3 / numBenchmarkUpdates);
-	printf("average %.2lf ps per cell\n", benchTime * 1.0e+12 / ((int64_t)numBenchmarkUpdates * (int64_t)benchCellsX * (int64_t)benchCellsY));
-	printf("speedup x%.2lf\n", referenceTime / benchTime);
+	/* the benchmark build runs the whole suite and quits, any files on the command line are benchmarked too */
+	runBenchmarks();
+	glfwSetWindowShouldClose(window, GLFW_TRUE);
 #endif
 
+	if (tracePath)
+		startTrace(tracePath);
+
 	uint64_t frameAccumulator1 = 0;
 	uint64_t frameAccumulator2 = 0;
 	double timeAccumulator = 0.0;
+	double logAccumulator = 0.0;
+	char gpuTimes[256] = "";
 	uint64_t t0 = glfwGetTimerValue();
 	double timerFrequency = (double)glfwGetTimerFrequency();
 	double timerPeriod = 1.0 / timerFrequency;
 
 	while (!glfwWindowShouldClose(window)) {
+		TracePhase framePhase, phase;
+		beginTracePhase(&framePhase, GL_FALSE);
+		beginTracePhase(&phase, GL_FALSE);
 		glfwPollEvents();
+		endTracePhase(&phase, "events");
 
 		uint64_t t1 = glfwGetTimerValue();
 		double deltaTime = ((t1 > t0) ? t1 - t0 : t0 - t1) * timerPeriod;
 		t0 = t1;
 
 		timeAccumulator += deltaTime;
+		logAccumulator += deltaTime;
 		frameAccumulator1 += 1;
 		frameAccumulator2 += 1;
+		recordHudFrame(deltaTime);
 
-		if (isRunning && frameAccumulator1 >= framesPerUpdate) {
+		if (isExportingOffline) {
+			beginTracePhase(&phase, GL_TRUE);
+			int query = isTimingEachGeneration() ? -1 : beginGpuTimer();
+			int numSteps = 0;
+			for (; numSteps < exporter.every && exporter.isExporting; ++numSteps)
+				stepCells();
+			endGpuTimer(query, numSteps);
+			endTracePhase(&phase, "update");
+			if (!exporter.isExporting)
+				glfwSetWindowShouldClose(window, GLFW_TRUE);
+		} else if (isRunning && frameAccumulator1 >= framesPerUpdate) {
 			frameAccumulator1 = 0;
+			beginTracePhase(&phase, GL_TRUE);
+			int query = isTimingEachGeneration() ? -1 : beginGpuTimer();
 			for (int i = 0; i < updatesPerFrame; ++i)
-				updateCells();
+				stepCells();
+			endGpuTimer(query, updatesPerFrame);
+			endTracePhase(&phase, "update");
 		}
+		beginTracePhase(&phase, GL_TRUE);
+		int query = beginGpuTimer();
 		renderCells();
+		endGpuTimer(query, GPU_TIMER_RENDER);
+		drawHud();
+		endTracePhase(&phase, "render");
 
 		if (timeAccumulator > 0.05) {
 			char title[512];
@@ -997,14 +7132,55 @@ int main(void) {
 			else
 				snprintf(title, sizeof(title), "GPU Life - %s - %lg steps per frame @ PAUSED - generation %d", 
 					patternName, generationsPerFrame, generation);
+			/* gpu times come in a few frames late, so the last ones stay up until there are new ones */
+			char newGpuTimes[256];
+			formatGpuTimes(&gpuTimer.title, newGpuTimes, sizeof(newGpuTimes));
+			if (newGpuTimes[0]) {
+				memcpy(gpuTimes, newGpuTimes, sizeof(gpuTimes));
+				memset(&gpuTimer.title, 0, sizeof(gpuTimer.title));
+			}
+			if (gpuTimes[0]) {
+				size_t length = strlen(title);
+				snprintf(title + length, sizeof(title) - length, " - %s", gpuTimes);
+			}
+			if (patternLoad.isLoading) {
+				size_t length = strlen(title);
+				int steps = loadSteps;
+				if (steps > 0)
+					snprintf(title + length, sizeof(title) - length, " - loading %.200s .. %d%%", patternLoad.file, (int)(100.0 * loadStepsDone / steps));
+				else
+					snprintf(title + length, sizeof(title) - length, " - loading %.200s ..", patternLoad.file);
+			}
 			glfwSetWindowTitle(window, title);
 			timeAccumulator = 0;
 			frameAccumulator2 = 0;
 		}
+		if (logAccumulator > 1.0) {
+			logGpuTimes();
+			logAccumulator = 0;
+		}
 
+		beginTracePhase(&phase, GL_FALSE);
+		pollSnapshotSave(GL_FALSE);
+		pollRecorder();
+		pollExporter();
+		pollPatternLoad(GL_FALSE);
+		pollTracer();
+		pollGpuTimer();
+		endTracePhase(&phase, "poll");
+		beginTracePhase(&phase, GL_FALSE);
 		glfwSwapBuffers(window);
+		endTracePhase(&phase, "swap");
+		endTracePhase(&framePhase, "frame");
 	}
 
+	pollPatternLoad(GL_TRUE);
+	pollSnapshotSave(GL_TRUE);
+	stopRecording();
+	stopExport();
+	stopTrace();
+	closeRecording();
+
 	glCheckErrors();
 	glDeleteTextures(1, &cellsRead);
 	glDeleteTextures(1, &cellsWrite);
@@ -1012,11 +7188,28 @@ int main(void) {
 	glDeleteFramebuffers(1, &cellsWriteFramebuffer);
 	glDeleteProgram(renderProgram);
  	glDeleteProgram(updateProgram);
+	glDeleteProgram(runProgram);
+	glDeleteProgram(hudProgram);
 	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteVertexArrays(1, &runVertexArray);
+	glDeleteVertexArrays(1, &hudVertexArray);
 	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteBuffers(1, &hudVertexBuffer);
+	glDeleteBuffers(NUM_UPLOAD_BUFFERS, uploadBuffers);
+	glDeleteBuffers(1, &snapshotSave.buffer);
+	glDeleteBuffers(NUM_RECORD_BUFFERS, recorder.buffers);
+	glDeleteBuffers(NUM_EXPORT_BUFFERS, exporter.buffers);
+	glDeleteQueries(NUM_TRACE_QUERIES, tracer.queries);
+	glDeleteQueries(NUM_GPU_TIMER_QUERIES, gpuTimer.queries);
 	glCheckErrors();
 	free(patternName);
+	free(hud.vertices);
 	glfwDestroyWindow(window);
 	glfwTerminate();
+#ifdef BENCHMARK
+	/* so that a regression against the baseline can fail a build */
+	return benchmark.exitCode;
+#else
 	return 0;
+#endif
 }
\ No newline at end of file